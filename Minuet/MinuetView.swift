@@ -11,6 +11,7 @@ import MNRayTrace
 
 class MinuetView: NSView {
     let renderer: OpaquePointer
+    let renderThread: OpaquePointer
     let camera: OpaquePointer
     
     private var bitmapContext: CGContext?
@@ -25,6 +26,7 @@ class MinuetView: NSView {
     
     override init(frame frameRect: NSRect) {
         renderer = mn_make_renderer()
+        renderThread = mn_make_render_thread(renderer)
         camera = mn_make_camera(45, 0.1, 100)
         viewport = Viewport(width: Int(frameRect.width), height: Int(frameRect.height))
         
@@ -32,6 +34,7 @@ class MinuetView: NSView {
         configureBitmapContext(viewport: viewport)
         
         pthread_mutex_init(&viewportLock, nil)
+        mn_render_thread_start(renderThread)
     }
     
     convenience init() {
@@ -43,6 +46,7 @@ class MinuetView: NSView {
     }
     
     deinit {
+        mn_render_thread_stop(renderThread)
         pthread_mutex_destroy(&viewportLock)
     }
     
@@ -98,14 +102,18 @@ class MinuetView: NSView {
         let viewportWidth = Int16(currentViewport.width)
         let viewportHeight = Int16(currentViewport.height)
         mn_camera_resize(camera, viewportWidth, viewportHeight)
-        mn_camera_update(camera, renderer, input, dt)
-        mn_renderer_resize(renderer, viewportWidth, viewportHeight)
+        let cameraChanged = mn_camera_handle_input(camera, input, dt)
+        mn_render_thread_submit(renderThread, scene, camera, cameraChanged)
         
-        if let image = mn_renderer_render(renderer, scene, camera), let imageData = mn_image_get_data(image) {
+        // NOTE(christian): The render thread may still be finishing a frame at the old size right after a resize; that one
+        // is skipped rather than waited for.
+        if let image = mn_render_thread_acquire_image(renderThread), let imageData = mn_image_get_data(image) {
             let imageWidth = mn_image_get_width(image)
             let imageHeight = mn_image_get_height(image)
-            let pixelCount = Int(imageWidth) * Int(imageHeight)
-            contextData.copyMemory(from: imageData, byteCount: pixelCount * context.bitsPerPixel/8)
+            if Int(imageWidth) == context.width && Int(imageHeight) == context.height {
+                let pixelCount = Int(imageWidth) * Int(imageHeight)
+                contextData.copyMemory(from: imageData, byteCount: pixelCount * context.bitsPerPixel/8)
+            }
         }
     }
     
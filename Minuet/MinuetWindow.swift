@@ -111,7 +111,7 @@ class MinuetWindow: FSWindow {
         timingToken = mn_platform_timing_start()
         
         minuetView.update(input: input, scene: scene, dt: Float(dt/1000))
-        uiView.update(scene: scene, renderer: minuetView.renderer, platform: mn_platform_get())
+        uiView.update(scene: scene, renderThread: minuetView.renderThread, platform: mn_platform_get())
         
         // NOTE(christian): Synchronize with display link thread to keep this thread running at the monitor's refresh rate.
         pthread_mutex_lock(&frameLock)
@@ -0,0 +1,399 @@
+//
+//  minuet_bench.cpp
+//  Minuet
+//
+//  Created by Christian Floisand on 2026-10-16.
+//
+//  Renders a fixed matrix of canonical scenes, resolutions and thread counts and reports throughput as JSON, so runs can be
+//  diffed against each other to catch regressions and compare kernels.
+//
+
+#include "minuet_ray_trace.h"
+#include "minuet_camera.h"
+#include "minuet_renderer.h"
+#include "minuet_scene.h"
+#include "fs_simd.h"
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+#pragma mark - Options
+
+struct mnBenchScene {
+    const char *name;
+    fsu32 sphereCount; // 0 = the default scene from mn_make_scene
+};
+
+struct mnBenchResolution {
+    fsu32 width;
+    fsu32 height;
+};
+
+static const mnBenchScene kCanonicalScenes[] = {
+    {"default", 0},
+    {"random_1k", 1000},
+    {"random_100k", 100000},
+    {"random_1m", 1000000},
+};
+
+struct mnBenchMode {
+    const char *name;
+    mnRenderer::ExecutionMode executionMode;
+};
+
+static const mnBenchMode kExecutionModes[] = {
+    {"megakernel", mnRenderer::ExecutionMode::megakernel},
+    {"wavefront", mnRenderer::ExecutionMode::wavefront},
+};
+
+struct mnBenchOptions {
+    std::vector<mnBenchScene> scenes;
+    std::vector<mnBenchMode> modes;
+    std::vector<mnBenchResolution> resolutions;
+    std::vector<fsu32> threadCounts;
+    fsu32 warmupFrames = 2;
+    fsu32 iterations = 8;
+    fsu32 samplesPerPixel = 1;
+    std::string outputPath; // Empty = stdout
+};
+
+static void
+printUsage(const char *program) {
+    fprintf(stderr,
+            "usage: %s [options]\n"
+            "  --scenes LIST        comma-separated subset of default,random_1k,random_100k,random_1m (default: all)\n"
+            "  --resolutions LIST   comma-separated WxH list (default: 320x180,1280x720)\n"
+            "  --threads LIST       comma-separated worker counts, 0 = all hardware threads (default: 1,0)\n"
+            "  --modes LIST         comma-separated subset of megakernel,wavefront (default: megakernel)\n"
+            "  --warmup N           untimed frames before each measurement (default: 2)\n"
+            "  --iterations N       timed frames per measurement (default: 8)\n"
+            "  --spp N              samples per pixel per frame (default: 1)\n"
+            "  -o, --output PATH    write the JSON report to PATH instead of stdout\n",
+            program);
+}
+
+static bool
+parseUnsigned(const char *text, fsu32& value) {
+    char *end = nullptr;
+    unsigned long result = strtoul(text, &end, 10);
+    if (end == text || *end != '\0') {
+        return false;
+    }
+    value = (fsu32)result;
+    return true;
+}
+
+static std::vector<std::string>
+splitList(const char *text) {
+    std::vector<std::string> items;
+    std::string item;
+    for (const char *c = text; ; ++c) {
+        if (*c == ',' || *c == '\0') {
+            if (!item.empty()) {
+                items.push_back(item);
+            }
+            item.clear();
+            if (*c == '\0') {
+                break;
+            }
+        } else {
+            item += *c;
+        }
+    }
+    return items;
+}
+
+static bool
+parseScenes(const char *text, std::vector<mnBenchScene>& scenes) {
+    scenes.clear();
+    for (const std::string& name : splitList(text)) {
+        bool found = false;
+        for (const mnBenchScene& scene : kCanonicalScenes) {
+            if (name == scene.name) {
+                scenes.push_back(scene);
+                found = true;
+            }
+        }
+        if (!found) {
+            return false;
+        }
+    }
+    return !scenes.empty();
+}
+
+static bool
+parseModes(const char *text, std::vector<mnBenchMode>& modes) {
+    modes.clear();
+    for (const std::string& name : splitList(text)) {
+        bool found = false;
+        for (const mnBenchMode& mode : kExecutionModes) {
+            if (name == mode.name) {
+                modes.push_back(mode);
+                found = true;
+            }
+        }
+        if (!found) {
+            return false;
+        }
+    }
+    return !modes.empty();
+}
+
+static bool
+parseResolutions(const char *text, std::vector<mnBenchResolution>& resolutions) {
+    resolutions.clear();
+    for (const std::string& item : splitList(text)) {
+        mnBenchResolution resolution;
+        char trailing;
+        if (sscanf(item.c_str(), "%ux%u%c", &resolution.width, &resolution.height, &trailing) != 2 ||
+            resolution.width == 0 || resolution.height == 0 || resolution.width > INT16_MAX || resolution.height > INT16_MAX) {
+            return false;
+        }
+        resolutions.push_back(resolution);
+    }
+    return !resolutions.empty();
+}
+
+static bool
+parseThreadCounts(const char *text, std::vector<fsu32>& threadCounts) {
+    threadCounts.clear();
+    for (const std::string& item : splitList(text)) {
+        fsu32 count;
+        if (!parseUnsigned(item.c_str(), count)) {
+            return false;
+        }
+        threadCounts.push_back(count);
+    }
+    return !threadCounts.empty();
+}
+
+static bool
+parseOptions(int argc, char **argv, mnBenchOptions& options) {
+    options.scenes.assign(kCanonicalScenes, kCanonicalScenes + fsArrayCount(kCanonicalScenes));
+    options.resolutions = {{320, 180}, {1280, 720}};
+    options.threadCounts = {1, 0};
+    options.modes = {kExecutionModes[0]};
+    
+    for (int i = 1; i < argc; ++i) {
+        const char *arg = argv[i];
+        if (strcmp(arg, "--help") == 0) {
+            return false;
+        }
+        
+        const char *value = (i + 1 < argc ? argv[++i] : nullptr);
+        bool ok = (value != nullptr);
+        if (!ok) {
+            fprintf(stderr, "error: missing value for %s\n", arg);
+            return false;
+        } else if (strcmp(arg, "--scenes") == 0) {
+            ok = parseScenes(value, options.scenes);
+        } else if (strcmp(arg, "--resolutions") == 0) {
+            ok = parseResolutions(value, options.resolutions);
+        } else if (strcmp(arg, "--threads") == 0) {
+            ok = parseThreadCounts(value, options.threadCounts);
+        } else if (strcmp(arg, "--modes") == 0) {
+            ok = parseModes(value, options.modes);
+        } else if (strcmp(arg, "--warmup") == 0) {
+            ok = parseUnsigned(value, options.warmupFrames);
+        } else if (strcmp(arg, "--iterations") == 0) {
+            ok = parseUnsigned(value, options.iterations) && options.iterations > 0;
+        } else if (strcmp(arg, "--spp") == 0) {
+            ok = parseUnsigned(value, options.samplesPerPixel) && options.samplesPerPixel > 0;
+        } else if (strcmp(arg, "-o") == 0 || strcmp(arg, "--output") == 0) {
+            options.outputPath = value;
+        } else {
+            fprintf(stderr, "error: unknown option %s\n", arg);
+            return false;
+        }
+        
+        if (!ok) {
+            fprintf(stderr, "error: invalid value '%s' for %s\n", value, arg);
+            return false;
+        }
+    }
+    
+    return true;
+}
+
+
+#pragma mark - Measurement
+
+struct mnBenchResult {
+    const char *sceneName;
+    const char *modeName;
+    fsu32 sphereCount;
+    fsu32 width;
+    fsu32 height;
+    fsu32 threadCount;
+    fsr64 firstFrameMs;     // Includes building the BVH and SoA mirror for the scene
+    fsr64 meanMs;
+    fsr64 varianceMs;       // Sample variance of the per-frame times
+    fsr64 minMs;
+    fsr64 maxMs;
+    fsr64 primaryRaysPerSecond;
+    fsr64 totalRaysPerSecond;
+    fsr64 raysPerFrame;
+    fsr64 sphereTestsPerRay;    // 0 unless built with MN_STATS
+};
+
+static mnBenchResult
+measure(const mnScene& scene, const mnBenchScene& benchScene, const mnBenchMode& mode, const mnBenchResolution& resolution,
+        fsu32 threadCount, const mnBenchOptions& options) {
+    mnCamera camera(45.f, 0.1f, 100.f);
+    camera.resize((fsi16)resolution.width, (fsi16)resolution.height);
+    camera.setView({0.f, 0.f, 20.f}, {0.f, 0.f, -1.f});
+    
+    // NOTE(christian): Accumulation is off so every frame traces the same paths and the workload is identical across runs.
+    // The primary hit cache is off too, since with a static camera it would skip primary rays after the first frame.
+    mnRenderer renderer;
+    mnRenderer::Settings& settings = renderer.getSettings();
+    settings.accumulate = false;
+    settings.cachePrimaryHits = false;
+    settings.executionMode = mode.executionMode;
+    settings.threadCount = threadCount;
+    settings.samplesPerPixel = options.samplesPerPixel;
+    renderer.resize((fsi16)resolution.width, (fsi16)resolution.height);
+    
+    mnBenchResult result = {};
+    result.sceneName = benchScene.name;
+    result.modeName = mode.name;
+    result.sphereCount = (fsu32)scene.spheres.size();
+    result.width = resolution.width;
+    result.height = resolution.height;
+    result.threadCount = (threadCount > 0 ? threadCount : fsMax(std::thread::hardware_concurrency(), 1u));
+    
+    renderer.render(scene, camera);
+    result.firstFrameMs = renderer.lastRenderTime;
+    
+    for (fsu32 frame = 0; frame < options.warmupFrames; ++frame) {
+        renderer.render(scene, camera);
+    }
+    
+    std::vector<fsr64> frameTimes(options.iterations);
+    fsr64 totalMs = 0.0;
+    fsr64 totalRays = 0.0;
+    fsr64 totalSphereTests = 0.0;
+    for (fsu32 frame = 0; frame < options.iterations; ++frame) {
+        renderer.render(scene, camera);
+        frameTimes[frame] = renderer.lastRenderTime;
+        totalMs += renderer.lastRenderTime;
+        totalRays += (fsr64)renderer.getStats().rayCount;
+        totalSphereTests += (fsr64)renderer.getStats().sphereTests;
+    }
+    
+    result.meanMs = totalMs / options.iterations;
+    result.minMs = frameTimes[0];
+    result.maxMs = frameTimes[0];
+    fsr64 sumSquares = 0.0;
+    for (fsr64 ms : frameTimes) {
+        sumSquares += (ms - result.meanMs) * (ms - result.meanMs);
+        result.minMs = fsMin(result.minMs, ms);
+        result.maxMs = fsMax(result.maxMs, ms);
+    }
+    result.varianceMs = (options.iterations > 1 ? sumSquares / (options.iterations - 1) : 0.0);
+    
+    fsr64 primaryRays = (fsr64)resolution.width * resolution.height * options.samplesPerPixel * options.iterations;
+    result.primaryRaysPerSecond = primaryRays / (totalMs * 0.001);
+    result.totalRaysPerSecond = totalRays / (totalMs * 0.001);
+    result.raysPerFrame = totalRays / options.iterations;
+    result.sphereTestsPerRay = (totalRays > 0.0 ? totalSphereTests / totalRays : 0.0);
+    
+    return result;
+}
+
+
+#pragma mark - Report
+
+static const char*
+simdName() {
+#if FS_SIMD_AVX2
+    return "avx2";
+#elif FS_SIMD_SSE
+    return "sse";
+#elif FS_SIMD_NEON
+    return "neon";
+#else
+    return "scalar";
+#endif
+}
+
+static void
+writeReport(FILE *file, const mnBenchOptions& options, const std::vector<mnBenchResult>& results) {
+    fprintf(file, "{\n");
+    fprintf(file, "  \"benchmark\": \"minuet\",\n");
+    fprintf(file, "  \"config\": {\n");
+    fprintf(file, "    \"warmup_frames\": %u,\n", options.warmupFrames);
+    fprintf(file, "    \"iterations\": %u,\n", options.iterations);
+    fprintf(file, "    \"samples_per_pixel\": %u,\n", options.samplesPerPixel);
+    fprintf(file, "    \"hardware_threads\": %u,\n", std::thread::hardware_concurrency());
+    fprintf(file, "    \"simd\": \"%s\",\n", simdName());
+    fprintf(file, "    \"simd_width\": %d,\n", FS_SIMD_WIDTH);
+    fprintf(file, "    \"stats\": %s\n", (MN_STATS ? "true" : "false"));
+    fprintf(file, "  },\n");
+    fprintf(file, "  \"results\": [\n");
+    for (size_t i = 0; i < results.size(); ++i) {
+        const mnBenchResult& r = results[i];
+        fprintf(file, "    {\"scene\": \"%s\", \"mode\": \"%s\", \"spheres\": %u, \"width\": %u, \"height\": %u, \"threads\": %u, "
+                "\"first_frame_ms\": %.3f, \"ms_per_frame\": %.3f, \"ms_variance\": %.4f, \"ms_stddev\": %.4f, "
+                "\"ms_min\": %.3f, \"ms_max\": %.3f, \"primary_rays_per_sec\": %.0f, \"total_rays_per_sec\": %.0f, "
+                "\"mrays_per_sec\": %.3f, \"rays_per_frame\": %.0f, \"sphere_tests_per_ray\": %.2f}%s\n",
+                r.sceneName, r.modeName, r.sphereCount, r.width, r.height, r.threadCount,
+                r.firstFrameMs, r.meanMs, r.varianceMs, sqrt(r.varianceMs),
+                r.minMs, r.maxMs, r.primaryRaysPerSecond, r.totalRaysPerSecond,
+                r.totalRaysPerSecond * 1e-6, r.raysPerFrame, r.sphereTestsPerRay, (i + 1 < results.size() ? "," : ""));
+    }
+    fprintf(file, "  ]\n");
+    fprintf(file, "}\n");
+}
+
+
+#pragma mark - main
+
+int
+main(int argc, char **argv) {
+    mnBenchOptions options;
+    if (!parseOptions(argc, argv, options)) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    
+    mn_platform_initialize();
+    
+    std::vector<mnBenchResult> results;
+    for (const mnBenchScene& benchScene : options.scenes) {
+        std::unique_ptr<mnScene> scene(benchScene.sphereCount > 0 ? mn_make_random_scene(benchScene.sphereCount, 1) : mn_make_scene());
+        
+        for (const mnBenchResolution& resolution : options.resolutions) {
+            for (const mnBenchMode& mode : options.modes) {
+                for (fsu32 threadCount : options.threadCounts) {
+                    mnBenchResult result = measure(*scene, benchScene, mode, resolution, threadCount, options);
+                    fprintf(stderr, "%-12s %-10s %5ux%-5u %2u threads: %9.2f ms/frame  %8.2f Mrays/s\n", result.sceneName,
+                            result.modeName, result.width, result.height, result.threadCount, result.meanMs,
+                            result.totalRaysPerSecond * 1e-6);
+                    results.push_back(result);
+                }
+            }
+        }
+    }
+    
+    FILE *file = stdout;
+    if (!options.outputPath.empty()) {
+        file = fopen(options.outputPath.c_str(), "w");
+        if (!file) {
+            fprintf(stderr, "error: could not write '%s'\n", options.outputPath.c_str());
+            return 1;
+        }
+    }
+    
+    writeReport(file, options, results);
+    
+    if (file != stdout) {
+        fclose(file);
+    }
+    
+    return 0;
+}
@@ -0,0 +1,431 @@
+//
+//  minuet_render.cpp
+//  Minuet
+//
+//  Created by Christian Floisand on 2026-10-16.
+//
+//  Headless command-line front end: renders a scene for a number of accumulation frames and writes the result to a PPM
+//  (tonemapped, 8-bit) or PFM (linear radiance, 32-bit float) image.
+//
+
+#include "minuet_ray_trace.h"
+#include "minuet_camera.h"
+#include "minuet_renderer.h"
+#include "minuet_scene.h"
+#include "minuet_scene_file.h"
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+
+#pragma mark - Options
+
+struct mnRenderOptions {
+    std::string scene = "default";
+    std::string outputPath = "minuet.ppm";
+    fsu32 width = 1280;
+    fsu32 height = 720;
+    fsu32 samplesPerPixel = 1;
+    fsu32 frameCount = 16;
+    fsu32 threadCount = 0;
+    fsu32 seed = 1;
+    fsv3f position = {0.f, 0.f, 20.f};
+    fsv3f direction = {0.f, 0.f, -1.f};
+    fsr32 verticalFOV = 45.f;
+    fsu32 maxBounces = 5;
+    fsr32 adaptiveThreshold = 0.f; // 0 = adaptive sampling off
+    bool useBVH = true;
+    bool wavefront = false;
+    mnSamplerType samplerType = mnSamplerType::sobol;
+    mnRenderer::AccumulationFormat accumulationFormat = mnRenderer::AccumulationFormat::rgba32f;
+    mnToneMapper toneMapper = mnToneMapper::clamp;
+    bool primaryRayPackets = true;
+    bool cachePrimaryHits = true;
+    bool precomputedRayDirections = false;
+    bool russianRoulette = true;
+    bool nextEventEstimation = true;
+    bool quiet = false;
+};
+
+static void
+printUsage(const char *program) {
+    fprintf(stderr,
+            "usage: %s [options]\n"
+            "  -s, --scene NAME         default | random:COUNT | a binary (.mnb) or text (.mns) scene file (default: default)\n"
+            "  -o, --output PATH        output image; .pfm writes float radiance, anything else PPM (default: minuet.ppm)\n"
+            "  -w, --width N            image width (default: 1280)\n"
+            "  -h, --height N           image height (default: 720)\n"
+            "  -p, --spp N              samples per pixel per frame (default: 1)\n"
+            "  -f, --frames N           accumulation frames to render (default: 16)\n"
+            "  -t, --threads N          worker threads, 0 = all hardware threads (default: 0)\n"
+            "      --seed N             seed for random scenes (default: 1)\n"
+            "      --position X,Y,Z     camera position (default: 0,0,20)\n"
+            "      --direction X,Y,Z    camera forward direction (default: 0,0,-1)\n"
+            "      --fov DEGREES        vertical field of view (default: 45)\n"
+            "  -a, --adaptive ERROR     skip pixels whose relative standard error falls below ERROR (e.g. 0.02) and\n"
+            "                           spend their samples on noisier pixels (default: off)\n"
+            "  -b, --max-bounces N      maximum path length (default: 5)\n"
+            "      --sampler NAME       random | stratified | sobol | bluenoise (default: sobol)\n"
+            "      --tonemap NAME       clamp | reinhard | aces, applied before sRGB encoding for PPM output (default: clamp)\n"
+            "      --accumulation FMT   rgba32f | rgb32f | rgba16f; adaptive sampling always uses rgba32f (default: rgba32f)\n"
+            "      --no-roulette        trace every path to the bounce limit instead of using Russian roulette\n"
+            "      --no-nee             don't sample lights directly; only bounces that hit an emitter contribute\n"
+            "      --no-bvh             intersect every sphere and triangle instead of traversing the BVHs\n"
+            "      --wavefront          trace one bounce of every path at a time instead of whole paths per tile\n"
+            "      --no-packets         trace primary rays one at a time instead of in 8x8 packets\n"
+            "      --no-primary-cache   retrace primary rays every frame instead of reusing the first frame's hits\n"
+            "      --precomputed-rays   read camera ray directions from a per-pixel table instead of generating them\n"
+            "  -q, --quiet              don't print per-frame timings\n",
+            program);
+}
+
+static bool
+parseUnsigned(const char *text, fsu32& value) {
+    char *end = nullptr;
+    unsigned long result = strtoul(text, &end, 10);
+    if (end == text || *end != '\0') {
+        return false;
+    }
+    value = (fsu32)result;
+    return true;
+}
+
+static bool
+parseFloat(const char *text, fsr32& value) {
+    char *end = nullptr;
+    value = strtof(text, &end);
+    return (end != text && *end == '\0');
+}
+
+static bool
+parseVector(const char *text, fsv3f& value) {
+    return (sscanf(text, "%f,%f,%f", &value.x, &value.y, &value.z) == 3);
+}
+
+static bool
+parseSampler(const char *text, mnSamplerType& value) {
+    static const struct {
+        const char *name;
+        mnSamplerType type;
+    } kSamplers[] = {
+        {"random", mnSamplerType::random},
+        {"stratified", mnSamplerType::stratified},
+        {"sobol", mnSamplerType::sobol},
+        {"bluenoise", mnSamplerType::blueNoise},
+    };
+    for (const auto& sampler : kSamplers) {
+        if (strcmp(text, sampler.name) == 0) {
+            value = sampler.type;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool
+parseAccumulationFormat(const char *text, mnRenderer::AccumulationFormat& value) {
+    static const struct {
+        const char *name;
+        mnRenderer::AccumulationFormat format;
+    } kFormats[] = {
+        {"rgba32f", mnRenderer::AccumulationFormat::rgba32f},
+        {"rgb32f", mnRenderer::AccumulationFormat::rgb32f},
+        {"rgba16f", mnRenderer::AccumulationFormat::rgba16f},
+    };
+    for (const auto& format : kFormats) {
+        if (strcmp(text, format.name) == 0) {
+            value = format.format;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool
+parseToneMapper(const char *text, mnToneMapper& value) {
+    static const struct {
+        const char *name;
+        mnToneMapper toneMapper;
+    } kToneMappers[] = {
+        {"clamp", mnToneMapper::clamp},
+        {"reinhard", mnToneMapper::reinhard},
+        {"aces", mnToneMapper::aces},
+    };
+    for (const auto& toneMapper : kToneMappers) {
+        if (strcmp(text, toneMapper.name) == 0) {
+            value = toneMapper.toneMapper;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool
+isValueOption(const char *arg) {
+    static const char *kValueOptions[] = {
+        "-s", "--scene", "-o", "--output", "-w", "--width", "-h", "--height", "-p", "--spp", "-f", "--frames",
+        "-t", "--threads", "-a", "--adaptive", "-b", "--max-bounces", "--seed", "--position", "--direction", "--fov",
+        "--sampler", "--tonemap", "--accumulation"
+    };
+    for (const char *option : kValueOptions) {
+        if (strcmp(arg, option) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool
+parseOptions(int argc, char **argv, mnRenderOptions& options) {
+    for (int i = 1; i < argc; ++i) {
+        const char *arg = argv[i];
+        const char *value = (i + 1 < argc ? argv[i + 1] : nullptr);
+        bool ok = true;
+        bool consumedValue = true;
+        
+        if (strcmp(arg, "--help") == 0) {
+            return false;
+        } else if (strcmp(arg, "--no-bvh") == 0) {
+            options.useBVH = false;
+            consumedValue = false;
+        } else if (strcmp(arg, "--wavefront") == 0) {
+            options.wavefront = true;
+            consumedValue = false;
+        } else if (strcmp(arg, "--no-packets") == 0) {
+            options.primaryRayPackets = false;
+            consumedValue = false;
+        } else if (strcmp(arg, "--no-primary-cache") == 0) {
+            options.cachePrimaryHits = false;
+            consumedValue = false;
+        } else if (strcmp(arg, "--precomputed-rays") == 0) {
+            options.precomputedRayDirections = true;
+            consumedValue = false;
+        } else if (strcmp(arg, "--no-roulette") == 0) {
+            options.russianRoulette = false;
+            consumedValue = false;
+        } else if (strcmp(arg, "--no-nee") == 0) {
+            options.nextEventEstimation = false;
+            consumedValue = false;
+        } else if (strcmp(arg, "-q") == 0 || strcmp(arg, "--quiet") == 0) {
+            options.quiet = true;
+            consumedValue = false;
+        } else if (!isValueOption(arg)) {
+            fprintf(stderr, "error: unknown option %s\n", arg);
+            return false;
+        } else if (!value) {
+            fprintf(stderr, "error: missing value for %s\n", arg);
+            return false;
+        } else if (strcmp(arg, "-s") == 0 || strcmp(arg, "--scene") == 0) {
+            options.scene = value;
+        } else if (strcmp(arg, "-o") == 0 || strcmp(arg, "--output") == 0) {
+            options.outputPath = value;
+        } else if (strcmp(arg, "-w") == 0 || strcmp(arg, "--width") == 0) {
+            ok = parseUnsigned(value, options.width);
+        } else if (strcmp(arg, "-h") == 0 || strcmp(arg, "--height") == 0) {
+            ok = parseUnsigned(value, options.height);
+        } else if (strcmp(arg, "-p") == 0 || strcmp(arg, "--spp") == 0) {
+            ok = parseUnsigned(value, options.samplesPerPixel);
+        } else if (strcmp(arg, "-f") == 0 || strcmp(arg, "--frames") == 0) {
+            ok = parseUnsigned(value, options.frameCount);
+        } else if (strcmp(arg, "-t") == 0 || strcmp(arg, "--threads") == 0) {
+            ok = parseUnsigned(value, options.threadCount);
+        } else if (strcmp(arg, "-a") == 0 || strcmp(arg, "--adaptive") == 0) {
+            ok = parseFloat(value, options.adaptiveThreshold) && options.adaptiveThreshold >= 0.f;
+        } else if (strcmp(arg, "-b") == 0 || strcmp(arg, "--max-bounces") == 0) {
+            ok = parseUnsigned(value, options.maxBounces);
+        } else if (strcmp(arg, "--seed") == 0) {
+            ok = parseUnsigned(value, options.seed);
+        } else if (strcmp(arg, "--position") == 0) {
+            ok = parseVector(value, options.position);
+        } else if (strcmp(arg, "--direction") == 0) {
+            ok = parseVector(value, options.direction);
+        } else if (strcmp(arg, "--fov") == 0) {
+            ok = parseFloat(value, options.verticalFOV);
+        } else if (strcmp(arg, "--sampler") == 0) {
+            ok = parseSampler(value, options.samplerType);
+        } else if (strcmp(arg, "--tonemap") == 0) {
+            ok = parseToneMapper(value, options.toneMapper);
+        } else if (strcmp(arg, "--accumulation") == 0) {
+            ok = parseAccumulationFormat(value, options.accumulationFormat);
+        }
+        
+        if (!ok) {
+            fprintf(stderr, "error: invalid value '%s' for %s\n", value, arg);
+            return false;
+        }
+        if (consumedValue) {
+            ++i;
+        }
+    }
+    
+    if (options.width == 0 || options.height == 0 || options.width > INT16_MAX || options.height > INT16_MAX) {
+        fprintf(stderr, "error: resolution must be between 1 and %d in each dimension\n", INT16_MAX);
+        return false;
+    }
+    if (options.samplesPerPixel == 0 || options.frameCount == 0) {
+        fprintf(stderr, "error: --spp and --frames must be at least 1\n");
+        return false;
+    }
+    if (fs_vlength(options.direction) == 0.f) {
+        fprintf(stderr, "error: camera direction must be non-zero\n");
+        return false;
+    }
+    
+    return true;
+}
+
+static mnScene*
+makeScene(const std::string& name, fsu32 seed, std::string& error) {
+    if (name == "default") {
+        return mn_make_scene();
+    }
+    
+    const char *kRandomPrefix = "random:";
+    if (name.compare(0, strlen(kRandomPrefix), kRandomPrefix) == 0) {
+        fsu32 sphereCount;
+        if (parseUnsigned(name.c_str() + strlen(kRandomPrefix), sphereCount) && sphereCount > 0) {
+            return mn_make_random_scene(sphereCount, seed);
+        }
+        error = "invalid sphere count in '" + name + "'";
+        return nullptr;
+    }
+    
+    return mn_load_scene_file(name.c_str(), &error);
+}
+
+
+#pragma mark - Image output
+
+static bool
+hasSuffix(const std::string& text, const char *suffix) {
+    size_t length = strlen(suffix);
+    return (text.size() >= length && text.compare(text.size() - length, length, suffix) == 0);
+}
+
+/*! @brief Writes the renderer's tonemapped pixels as a binary PPM. Image rows are stored bottom-up, PPM rows top-down. */
+static bool
+writePPM(const char *path, const mnImage& image) {
+    FILE *file = fopen(path, "wb");
+    if (!file) {
+        return false;
+    }
+    
+    fprintf(file, "P6\n%d %d\n255\n", image.width, image.height);
+    
+    std::vector<fsu8> row(image.width * 3);
+    for (fsi32 y = image.height - 1; y >= 0; --y) {
+        const fsu32 *pixels = image.pixelData + y * image.width;
+        for (fsi32 x = 0; x < image.width; ++x) {
+            row[x * 3 + 0] = (fsu8)(pixels[x] >> 24);
+            row[x * 3 + 1] = (fsu8)(pixels[x] >> 16);
+            row[x * 3 + 2] = (fsu8)(pixels[x] >> 8);
+        }
+        fwrite(row.data(), 1, row.size(), file);
+    }
+    
+    bool ok = (ferror(file) == 0);
+    fclose(file);
+    return ok;
+}
+
+/*! @brief Writes linear RGB radiance as a little-endian PFM. PFM rows are stored bottom-up, matching the renderer. */
+static bool
+writePFM(const char *path, fsu32 width, fsu32 height, const std::vector<fsr32>& rgb) {
+    FILE *file = fopen(path, "wb");
+    if (!file) {
+        return false;
+    }
+    
+    // NOTE(christian): A negative scale marks the data as little-endian, which is the byte order of every platform we target.
+    fprintf(file, "PF\n%u %u\n-1.0\n", width, height);
+    fwrite(rgb.data(), sizeof(fsr32), rgb.size(), file);
+    
+    bool ok = (ferror(file) == 0);
+    fclose(file);
+    return ok;
+}
+
+
+#pragma mark - main
+
+int
+main(int argc, char **argv) {
+    mnRenderOptions options;
+    if (!parseOptions(argc, argv, options)) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    
+    std::string sceneError;
+    std::unique_ptr<mnScene> scene(makeScene(options.scene, options.seed, sceneError));
+    if (!scene) {
+        fprintf(stderr, "error: %s\n", sceneError.c_str());
+        return 1;
+    }
+    
+    mn_platform_initialize();
+    
+    mnCamera camera(options.verticalFOV, 0.1f, 100.f);
+    camera.resize((fsi16)options.width, (fsi16)options.height);
+    camera.setView(options.position, options.direction);
+    
+    mnRenderer renderer;
+    mnRenderer::Settings& settings = renderer.getSettings();
+    settings.accumulate = true;
+    settings.useBVH = options.useBVH;
+    settings.primaryRayPackets = options.primaryRayPackets;
+    settings.cachePrimaryHits = options.cachePrimaryHits;
+    settings.precomputedRayDirections = options.precomputedRayDirections;
+    settings.executionMode = (options.wavefront ? mnRenderer::ExecutionMode::wavefront : mnRenderer::ExecutionMode::megakernel);
+    settings.samplerType = options.samplerType;
+    settings.accumulationFormat = options.accumulationFormat;
+    settings.toneMapper = options.toneMapper;
+    settings.threadCount = options.threadCount;
+    settings.samplesPerPixel = options.samplesPerPixel;
+    settings.maxBounces = options.maxBounces;
+    settings.russianRoulette = options.russianRoulette;
+    settings.nextEventEstimation = options.nextEventEstimation;
+    settings.adaptiveSampling = (options.adaptiveThreshold > 0.f);
+    settings.adaptiveThreshold = options.adaptiveThreshold;
+    renderer.resize((fsi16)options.width, (fsi16)options.height);
+    renderer.resetFrameIndex();
+    
+    mnImage *image = nullptr;
+    fsr64 totalTime = 0.0;
+    for (fsu32 frame = 0; frame < options.frameCount; ++frame) {
+        image = renderer.render(*scene, camera);
+        totalTime += renderer.lastRenderTime;
+        if (!options.quiet) {
+            fprintf(stderr, "frame %u/%u: %.2f ms\n", frame + 1, options.frameCount, renderer.lastRenderTime);
+        }
+    }
+    
+    if (settings.adaptiveSampling) {
+        fprintf(stderr, "adaptive sampling: %u of %u pixels converged\n", renderer.getConvergedPixelCount(),
+                options.width * options.height);
+    }
+    size_t triangleCount = 0;
+    for (const mnMesh& mesh : scene->meshes) {
+        triangleCount += mesh.getTriangleCount();
+    }
+    fprintf(stderr, "rendered %zu spheres and %zu triangles at %ux%u, %u spp in %.2f ms (%.2f ms/frame)\n",
+            scene->spheres.size(), triangleCount, options.width, options.height, renderer.getAccumulatedSampleCount(),
+            totalTime, totalTime / options.frameCount);
+    
+    bool written;
+    if (hasSuffix(options.outputPath, ".pfm")) {
+        std::vector<fsr32> rgb(options.width * options.height * 3);
+        renderer.resolveRadiance(rgb.data());
+        written = writePFM(options.outputPath.c_str(), options.width, options.height, rgb);
+    } else {
+        written = writePPM(options.outputPath.c_str(), *image);
+    }
+    
+    if (!written) {
+        fprintf(stderr, "error: could not write '%s'\n", options.outputPath.c_str());
+        return 1;
+    }
+    
+    return 0;
+}
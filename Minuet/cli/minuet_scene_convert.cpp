@@ -0,0 +1,118 @@
+//
+//  minuet_scene_convert.cpp
+//  Minuet
+//
+//  Created by Christian Floisand on 2026-10-16.
+//
+//  Converts scenes between the text and binary scene file formats. Built-in scenes can be written out too, which is the
+//  easiest way to get a large scene to test loading with.
+//
+
+#include "minuet_ray_trace.h"
+#include "minuet_scene.h"
+#include "minuet_scene_file.h"
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <string>
+
+
+static void
+printUsage(const char *program) {
+    fprintf(stderr,
+            "usage: %s [options] INPUT OUTPUT\n"
+            "  INPUT                a binary or text scene file, default, or random:COUNT\n"
+            "  OUTPUT               a .mns path writes the text format, anything else the binary format\n"
+            "      --seed N         seed for random scenes (default: 1)\n",
+            program);
+}
+
+static bool
+parseUnsigned(const char *text, fsu32& value) {
+    char *end = nullptr;
+    unsigned long result = strtoul(text, &end, 10);
+    if (end == text || *end != '\0') {
+        return false;
+    }
+    value = (fsu32)result;
+    return true;
+}
+
+static bool
+hasSuffix(const std::string& text, const char *suffix) {
+    size_t length = strlen(suffix);
+    return (text.size() >= length && text.compare(text.size() - length, length, suffix) == 0);
+}
+
+static mnScene*
+makeScene(const std::string& name, fsu32 seed, std::string& error) {
+    if (name == "default") {
+        return mn_make_scene();
+    }
+    
+    const char *kRandomPrefix = "random:";
+    if (name.compare(0, strlen(kRandomPrefix), kRandomPrefix) == 0) {
+        fsu32 sphereCount;
+        if (parseUnsigned(name.c_str() + strlen(kRandomPrefix), sphereCount) && sphereCount > 0) {
+            return mn_make_random_scene(sphereCount, seed);
+        }
+        error = "invalid sphere count in '" + name + "'";
+        return nullptr;
+    }
+    
+    return mn_load_scene_file(name.c_str(), &error);
+}
+
+static fsr64
+millisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<fsr64, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+
+#pragma mark - main
+
+int
+main(int argc, char **argv) {
+    fsu32 seed = 1;
+    const char *paths[2] = {};
+    fsu32 pathCount = 0;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--seed") == 0) {
+            if (i + 1 >= argc || !parseUnsigned(argv[i + 1], seed)) {
+                printUsage(argv[0]);
+                return 1;
+            }
+            ++i;
+        } else if (argv[i][0] == '-' || pathCount == 2) {
+            printUsage(argv[0]);
+            return 1;
+        } else {
+            paths[pathCount++] = argv[i];
+        }
+    }
+    if (pathCount != 2) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    
+    std::string error;
+    auto start = std::chrono::steady_clock::now();
+    std::unique_ptr<mnScene> scene(makeScene(paths[0], seed, error));
+    if (!scene) {
+        fprintf(stderr, "error: %s\n", error.c_str());
+        return 1;
+    }
+    fsr64 loadTime = millisecondsSince(start);
+    
+    start = std::chrono::steady_clock::now();
+    bool text = hasSuffix(paths[1], ".mns");
+    bool written = (text ? mn_write_scene_text(*scene, paths[1], &error) : mn_write_scene_binary(*scene, paths[1], &error));
+    if (!written) {
+        fprintf(stderr, "error: %s\n", error.c_str());
+        return 1;
+    }
+    
+    fprintf(stderr, "converted %zu spheres and %zu materials: read in %.2f ms, wrote %s in %.2f ms\n", scene->spheres.size(),
+            scene->materials.size(), loadTime, (text ? "text" : "binary"), millisecondsSince(start));
+    return 0;
+}
@@ -374,6 +374,39 @@ struct fsRawInput {
             fsButtonState RBracket;
             fsButtonState Quote;
         };
+#else
+        // NOTE(christian): Headless/other platforms index keys by their uppercase ASCII code.
+        fsButtonState keyboardButtons[128];
+        struct {
+            fsButtonState _unassigned0[65];
+            
+            fsButtonState A;
+            fsButtonState B;
+            fsButtonState C;
+            fsButtonState D;
+            fsButtonState E;
+            fsButtonState F;
+            fsButtonState G;
+            fsButtonState H;
+            fsButtonState I;
+            fsButtonState J;
+            fsButtonState K;
+            fsButtonState L;
+            fsButtonState M;
+            fsButtonState N;
+            fsButtonState O;
+            fsButtonState P;
+            fsButtonState Q;
+            fsButtonState R;
+            fsButtonState S;
+            fsButtonState T;
+            fsButtonState U;
+            fsButtonState V;
+            fsButtonState W;
+            fsButtonState X;
+            fsButtonState Y;
+            fsButtonState Z;
+        };
 #endif
         
     };
@@ -6,8 +6,16 @@
 #include <chrono>
 #include <cmath>
 #include <climits>
+#include <cstring>
 #include <string>
 
+#if FS_PLATFORM_OSX || FS_PLATFORM_LINUX
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 
 #pragma mark - Memory
 // ===================================================================================================
@@ -33,6 +41,29 @@ fs_memcmp_equal(const void *ptr1, const void *ptr2, size_t size) {
     return (memcmp(ptr1, ptr2, size) == 0);
 }
 
+void*
+fs_aligned_alloc(size_t size, size_t alignment) {
+    fsAssert(fsIsPowerOf2(alignment));
+#if FS_PLATFORM_WINDOWS
+    return _aligned_malloc(size, alignment);
+#else
+    void *ptr = nullptr;
+    if (posix_memalign(&ptr, fsMax(alignment, sizeof(void *)), size) != 0) {
+        return nullptr;
+    }
+    return ptr;
+#endif
+}
+
+void
+fs_aligned_free(void *ptr) {
+#if FS_PLATFORM_WINDOWS
+    _aligned_free(ptr);
+#else
+    free(ptr);
+#endif
+}
+
 
 #pragma mark - Math
 // ===================================================================================================
@@ -374,7 +405,7 @@ fs_clz(fsu8 byte) {
 fsu32
 fs_clz(fsu32 val) {
     if (val == 0) return 32;
-#if FS_PLATFORM_OSX
+#if FS_PLATFORM_OSX || FS_PLATFORM_LINUX
     return __builtin_clz(val);
 #elif FS_PLATFORM_WINDOWS
 	return __lzcnt(val);
@@ -384,8 +415,8 @@ fs_clz(fsu32 val) {
 fsu32
 fs_clz(fsu64 val) {
     if (val == 0) return 64;
-#if FS_PLATFORM_OSX
-    return __builtin_clzl(val);
+#if FS_PLATFORM_OSX || FS_PLATFORM_LINUX
+    return __builtin_clzll(val);
 #elif FS_PLATFORM_WINDOWS
 #if FS_ENV_64BIT
     return __lzcnt64(val);
@@ -421,7 +452,7 @@ fs_ffs(fsu8 byte) {
 
 fsu32
 fs_ffs(fsu32 val) {
-#if FS_PLATFORM_OSX
+#if FS_PLATFORM_OSX || FS_PLATFORM_LINUX
     return __builtin_ffs(val);
 #elif FS_PLATFORM_WINDOWS
 	unsigned long index;
@@ -509,6 +540,38 @@ fs_read_file(const char *fileName, void *buffer, size_t bufferSize) {
 	return false;
 }
 
+const void*
+fs_map_file(const char *fileName, size_t *fileSize) {
+    void *fileData = nullptr;
+#if FS_PLATFORM_OSX || FS_PLATFORM_LINUX
+    int fd = open(fileName, O_RDONLY);
+    if (fd != -1) {
+        struct stat fileStat;
+        if (fstat(fd, &fileStat) == 0 && fileStat.st_size > 0) {
+            fileData = mmap(nullptr, (size_t)fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (fileData == MAP_FAILED) {
+                fileData = nullptr;
+            } else if (fileSize) {
+                *fileSize = (size_t)fileStat.st_size;
+            }
+        }
+        
+        // NOTE(christian): The mapping holds its own reference to the file.
+        close(fd);
+    }
+#endif
+    return fileData;
+}
+
+void
+fs_unmap_file(const void *fileData, size_t fileSize) {
+#if FS_PLATFORM_OSX || FS_PLATFORM_LINUX
+    if (fileData) {
+        munmap((void *)fileData, fileSize);
+    }
+#endif
+}
+
 char*
 fs_read_line(FILE *file) {
     size_t lineLength = 0;
@@ -641,7 +704,7 @@ fs_split(const char *str, char delimeter, size_t *count) {
 char*
 fs_get_last_path_component(const char *path) {
     char pathDelim;
-#if FS_PLATFORM_OSX
+#if FS_PLATFORM_OSX || FS_PLATFORM_LINUX
     pathDelim = '/';
 #elif FS_PLATFORM_WINDOWS
     pathDelim = '\\';
@@ -671,7 +734,7 @@ fs_get_last_path_component(const char *path) {
 char*
 fs_trim_last_path_component(const char *path) {
     char pathDelim;
-#if FS_PLATFORM_OSX
+#if FS_PLATFORM_OSX || FS_PLATFORM_LINUX
     pathDelim = '/';
 #elif FS_PLATFORM_WINDOWS
     pathDelim = '\\';
@@ -697,7 +760,7 @@ fs_trim_last_path_component(const char *path) {
 char*
 fs_append_path_component(const char *path, const char *component) {
     char pathDelim;
-#if FS_PLATFORM_OSX
+#if FS_PLATFORM_OSX || FS_PLATFORM_LINUX
     pathDelim = '/';
 #elif FS_PLATFORM_WINDOWS
     pathDelim = '\\';
@@ -737,7 +800,7 @@ fs_append_path_component(const char *path, const char *component) {
 char*
 fs_get_file_extension(const char *file) {
     char pathDelim;
-#if FS_PLATFORM_OSX
+#if FS_PLATFORM_OSX || FS_PLATFORM_LINUX
     pathDelim = '/';
 #elif FS_PLATFORM_WINDOWS
     pathDelim = '\\';
@@ -984,6 +1047,197 @@ fs_base64_decode(const char *string) {
 }
 
 
+#pragma mark - String views & Tokenizing
+// ===================================================================================================
+
+bool
+fs_are_equal(fsStringView view, const char *str) {
+    return (strlen(str) == view.length && memcmp(view.data, str, view.length) == 0);
+}
+
+static inline bool
+isDigit(char c) {
+    return ((unsigned)(c - '0') < 10);
+}
+
+static bool
+parseFloatSlow(fsStringView view, fsr32 *value) {
+    char buffer[64];
+    if (view.length >= sizeof(buffer)) {
+        return false;
+    }
+    memcpy(buffer, view.data, view.length);
+    buffer[view.length] = '\0';
+    
+    char *end = nullptr;
+    *value = strtof(buffer, &end);
+    return (end == buffer + view.length && view.length > 0);
+}
+
+bool
+fs_parse_float(fsStringView view, fsr32 *value) {
+    // NOTE(christian): Exact powers of ten as doubles. Up to 10^22 they are exactly representable, so a mantissa of at most 2^53
+    // scaled by one of them is a single correctly rounded double operation (Clinger's fast path). See below for the float.
+    static const fsr64 kPowersOf10[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20,
+        1e21, 1e22
+    };
+    const fsu64 kMaxExactMantissa = (fsu64)1 << 53;
+    
+    const char *at = view.data;
+    const char *end = view.data + view.length;
+    bool negative = false;
+    if (at < end && (*at == '-' || *at == '+')) {
+        negative = (*at == '-');
+        at++;
+    }
+    
+    fsu64 mantissa = 0;
+    fsi32 exponent = 0;
+    bool hasDigits = false;
+    bool exact = true;
+    for (; at < end && isDigit(*at); at++) {
+        hasDigits = true;
+        if (mantissa < kMaxExactMantissa / 10) {
+            mantissa = mantissa * 10 + (*at - '0');
+        } else {
+            exact &= (*at == '0');
+            exponent++;
+        }
+    }
+    if (at < end && *at == '.') {
+        for (at++; at < end && isDigit(*at); at++) {
+            hasDigits = true;
+            if (mantissa < kMaxExactMantissa / 10) {
+                mantissa = mantissa * 10 + (*at - '0');
+                exponent--;
+            } else {
+                exact &= (*at == '0');
+            }
+        }
+    }
+    if (!hasDigits) {
+        return parseFloatSlow(view, value);
+    }
+    
+    if (at < end && (*at == 'e' || *at == 'E')) {
+        at++;
+        bool negativeExponent = false;
+        if (at < end && (*at == '-' || *at == '+')) {
+            negativeExponent = (*at == '-');
+            at++;
+        }
+        if (at == end || !isDigit(*at)) {
+            return false;
+        }
+        fsi32 exponentValue = 0;
+        for (; at < end && isDigit(*at); at++) {
+            exponentValue = fsMin(exponentValue * 10 + (*at - '0'), 100000);
+        }
+        exponent += (negativeExponent ? -exponentValue : exponentValue);
+    }
+    if (at != end) {
+        return parseFloatSlow(view, value);
+    }
+    
+    if (mantissa == 0) {
+        *value = (negative ? -0.f : 0.f);
+        return true;
+    }
+    if (!exact || exponent < -22 || exponent > 22) {
+        return parseFloatSlow(view, value);
+    }
+    
+    fsr64 result = (fsr64)mantissa;
+    result = (exponent < 0 ? result / kPowersOf10[-exponent] : result * kPowersOf10[exponent]);
+    
+    // NOTE(christian): The double is the correctly rounded decimal, but rounding it again to float is only guaranteed to
+    // give the correctly rounded float when the double isn't exactly halfway between two floats; the first rounding may
+    // have landed it there from either side. Denormal and overflowing floats round differently, so they go the slow way too.
+    union { fsr64 f; fsu64 u; } bits = {result};
+    const fsu64 kBelowFloatMask = ((fsu64)1 << 29) - 1;
+    const fsu64 kHalfway = (fsu64)1 << 28;
+    if ((bits.u & kBelowFloatMask) == kHalfway || result < (fsr64)FLT_MIN || result > (fsr64)FLT_MAX) {
+        return parseFloatSlow(view, value);
+    }
+    *value = (fsr32)(negative ? -result : result);
+    return true;
+}
+
+bool
+fs_parse_integer(fsStringView view, fsi64 *value) {
+    const char *at = view.data;
+    const char *end = view.data + view.length;
+    bool negative = false;
+    if (at < end && (*at == '-' || *at == '+')) {
+        negative = (*at == '-');
+        at++;
+    }
+    if (at == end) {
+        return false;
+    }
+    
+    // NOTE(christian): Accumulated as a magnitude so that INT64_MIN, which has no positive counterpart, still parses.
+    fsu64 limit = (negative ? (fsu64)INT64_MAX + 1 : (fsu64)INT64_MAX);
+    fsu64 magnitude = 0;
+    for (; at < end; at++) {
+        if (!isDigit(*at)) {
+            return false;
+        }
+        fsu64 digit = (fsu64)(*at - '0');
+        if (magnitude > (limit - digit) / 10) {
+            return false;
+        }
+        magnitude = magnitude * 10 + digit;
+    }
+    
+    *value = (negative ? (fsi64)(0 - magnitude) : (fsi64)magnitude);
+    return true;
+}
+
+/*! @brief Same as fs_is_whitespace, but a single compare for the common case of printable characters. */
+static inline bool
+isSpaceOrLineEnding(char c) {
+    return ((unsigned char)c <= ' ' && (c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f'));
+}
+
+bool
+fsTokenizer::next_token(fsStringView *token) {
+    while (at < end && isSpaceOrLineEnding(*at) && *at != '\n') {
+        at++;
+    }
+    if (at == end || *at == '\n') {
+        return false;
+    }
+    if (*at == commentChar) {
+        while (at < end && *at != '\n') {
+            at++;
+        }
+        return false;
+    }
+    
+    const char *start = at;
+    while (at < end && !isSpaceOrLineEnding(*at) && *at != commentChar) {
+        at++;
+    }
+    token->data = start;
+    token->length = (size_t)(at - start);
+    return true;
+}
+
+bool
+fsTokenizer::next_line() {
+    const char *lineEnd = (const char *)memchr(at, '\n', (size_t)(end - at));
+    if (!lineEnd) {
+        at = end;
+        return false;
+    }
+    at = lineEnd + 1;
+    lineNumber++;
+    return true;
+}
+
+
 #pragma mark - Timing
 // ===================================================================================================
 
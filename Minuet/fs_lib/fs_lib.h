@@ -15,6 +15,13 @@
 #	else
 #		define FS_ENV_32BIT 1
 #	endif
+#elif defined(__linux__)
+#	define FS_PLATFORM_LINUX 1
+#	if defined(__LP64__)
+#		define FS_ENV_64BIT 1
+#	else
+#		define FS_ENV_32BIT 1
+#	endif
 #endif
 
 #if (defined(__i386__) || defined(__x86_64__) || defined(_M_IX86) || defined(_M_X64))
@@ -27,6 +34,8 @@
 
 #ifdef __clang__
 #	define FS_COMPILER_CLANG 1
+#elif defined(__GNUC__)
+#	define FS_COMPILER_GCC 1
 #elif defined(_MSC_VER)
 #	define FS_COMPILER_MSVC 1
 #endif
@@ -92,7 +101,7 @@ enum fsComparisonResult {
 
 #if defined(DEBUG) || defined(_DEBUG) || defined(FS_DEBUG)
 #   define FS_DEBUG 1
-#	if FS_PLATFORM_OSX
+#	if FS_PLATFORM_OSX || FS_PLATFORM_LINUX
 #		define fsAssert(expr) if (!(expr)) { __builtin_trap(); }
 #	elif FS_PLATFORM_WINDOWS
 #		define fsAssert(expr) if (!(expr)) { *(int *)0 = 0; }
@@ -172,6 +181,26 @@ void fs_memclear(void *ptr, size_t size);
 /*! @brief Compares \c size bytes in the two memory blocks pointed at by \c ptr1 and \c ptr2 
     and returns true if they are equal, and false otherwise. */
 bool fs_memcmp_equal(const void *ptr1, const void *ptr2, size_t size);
+/*! @brief Allocates \c size bytes aligned to \c alignment, which must be a power of 2. Free with \c fs_aligned_free. */
+void* fs_aligned_alloc(size_t size, size_t alignment);
+/*! @brief Frees memory allocated with \c fs_aligned_alloc. */
+void fs_aligned_free(void *ptr);
+
+/*! @brief Allocator for standard containers whose storage has to start on an \c Alignment boundary, e.g. a cache line. */
+template <typename T, size_t Alignment>
+struct fsAlignedAllocator {
+    typedef T value_type;
+    template <typename U> struct rebind { typedef fsAlignedAllocator<U, Alignment> other; };
+    
+    fsAlignedAllocator() = default;
+    template <typename U> fsAlignedAllocator(const fsAlignedAllocator<U, Alignment>&) {}
+    
+    T* allocate(size_t count) { return (T *)fs_aligned_alloc(count * sizeof(T), Alignment); }
+    void deallocate(T *ptr, size_t) { fs_aligned_free(ptr); }
+    
+    template <typename U> bool operator==(const fsAlignedAllocator<U, Alignment>&) const { return true; }
+    template <typename U> bool operator!=(const fsAlignedAllocator<U, Alignment>&) const { return false; }
+};
 
 
 // ==================================================================================
@@ -357,6 +386,13 @@ bool fs_read_file(const char *fileName, void **fileData, size_t *fileSize, void*
 	The method reads up to \c bufferSize number of bytes or the size of the file, whichever is smaller. */
 bool fs_read_file(const char *fileName, void *buffer, size_t bufferSize);
 
+/*! @brief Maps a file read-only into memory, and fills in its size in bytes into fileSize. Pages are read in as they are first
+    touched rather than up front. Returns null on failure or if the file is empty.
+    @note The caller is responsible for unmapping the data with \c fs_unmap_file. */
+const void* fs_map_file(const char *fileName, size_t *fileSize);
+/*! @brief Unmaps file data returned by \c fs_map_file. */
+void fs_unmap_file(const void *fileData, size_t fileSize);
+
 char* fs_read_line(FILE *file);
 
 char* fs_read_line(FILE *file, char *buffer, size_t maxLength);
@@ -419,6 +455,47 @@ char* fs_base64_urlencode(const char *string);
 fsu8* fs_base64_decode(const char *string);
 
 
+// ==================================================================================
+//                      String views & Tokenizing
+// ==================================================================================
+
+/*! @brief A run of characters inside someone else's buffer. It isn't null-terminated, and is only valid as long as the buffer is. */
+struct fsStringView {
+    const char *data = nullptr;
+    size_t length = 0;
+};
+
+/*! @brief Returns true if \c view holds exactly the null-terminated string \c str. */
+bool fs_are_equal(fsStringView view, const char *str);
+
+/*! @brief Parses all of \c view as a decimal float ([+-]digits[.digits][(e|E)[+-]digits]), giving the same result as strtof.
+    Common values are converted directly through a double; anything longer or out of range, values the double can't round
+    correctly to float, and inf, nan and hex floats, fall back to strtof. Returns false unless the whole view is a number. */
+bool fs_parse_float(fsStringView view, fsr32 *value);
+/*! @brief Parses all of \c view as a decimal integer with an optional sign. Returns false unless the whole view is a number that fits. */
+bool fs_parse_integer(fsStringView view, fsi64 *value);
+
+/*! @brief Splits text into whitespace-separated tokens one line at a time, handing out views into the text instead of copies.
+    Nothing is allocated, and the text doesn't need to be null-terminated, so it can be a mapped file. Everything from
+    \c commentChar to the end of a line is skipped. */
+struct fsTokenizer {
+    const char *at;
+    const char *end;
+    char commentChar;
+    fsu32 lineNumber = 1;
+    
+    
+    fsTokenizer(const char *text, size_t length, char commentChar = '\0')
+        : at(text), end(text + length), commentChar(commentChar)
+    {}
+    
+    /*! @brief Returns the next token on the current line in \c token, or false at the end of the line. */
+    bool next_token(fsStringView *token);
+    /*! @brief Moves to the start of the next line, skipping whatever is left of the current one. Returns false at the end of the text. */
+    bool next_line();
+};
+
+
 // ==================================================================================
 //                      Comparison
 // ==================================================================================
@@ -522,6 +599,8 @@ struct fsHash<char const* const&>
     }
 };
 
+// NOTE(christian): On LP64 Linux, int64_t is already long.
+#if !(FS_PLATFORM_LINUX && FS_ENV_64BIT)
 template<>
 struct fsHash<long>
 {
@@ -530,6 +609,7 @@ struct fsHash<long>
         return hash((int64_t)key);
     }
 };
+#endif
 
 
 // ==================================================================================
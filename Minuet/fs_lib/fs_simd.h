@@ -0,0 +1,550 @@
+/*  fs_simd.h - Flyingsand SIMD lanes
+ *  v. 0.1
+ */
+
+#pragma once
+#include "fs_lib.h"
+
+// NOTE: The lane width is chosen at compile time from the target instruction set: 8 lanes with AVX2, 4 lanes with SSE or NEON,
+// and a 4-lane scalar emulation everywhere else. Code written against fsWide/fsWideInt/fsWideMask compiles to any of them.
+#if FS_ARCH_INTEL && defined(__AVX2__)
+#   define FS_SIMD_AVX2 1
+#   define FS_SIMD_WIDTH 8
+#   include <immintrin.h>
+#elif FS_ARCH_INTEL && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#   define FS_SIMD_SSE 1
+#   define FS_SIMD_WIDTH 4
+#   include <emmintrin.h>
+#elif FS_ARCH_ARM && (defined(__ARM_NEON) || defined(__ARM_NEON__))
+#   define FS_SIMD_NEON 1
+#   define FS_SIMD_WIDTH 4
+#   include <arm_neon.h>
+#else
+#   define FS_SIMD_SCALAR 1
+#   define FS_SIMD_WIDTH 4
+#endif
+
+#define FS_SIMD_ALIGNMENT 32
+
+// Half precision conversions use F16C on Intel when the target has it (it comes with AVX2 on every CPU so far), and the
+// conversion instructions every AArch64 CPU has.
+#if FS_ARCH_INTEL && defined(__F16C__)
+#   define FS_SIMD_F16C 1
+#   include <immintrin.h>
+#elif FS_SIMD_NEON && defined(__aarch64__)
+#   define FS_SIMD_NEON_F16 1
+#endif
+
+
+#pragma mark - Types
+
+#if FS_SIMD_AVX2
+struct fsWide { __m256 v; };
+struct fsWideInt { __m256i v; };
+struct fsWideMask { __m256 v; };
+#elif FS_SIMD_SSE
+struct fsWide { __m128 v; };
+struct fsWideInt { __m128i v; };
+struct fsWideMask { __m128 v; };
+#elif FS_SIMD_NEON
+struct fsWide { float32x4_t v; };
+struct fsWideInt { int32x4_t v; };
+struct fsWideMask { uint32x4_t v; };
+#else
+struct fsWide { fsr32 v[FS_SIMD_WIDTH]; };
+struct fsWideInt { fsi32 v[FS_SIMD_WIDTH]; };
+struct fsWideMask { bool v[FS_SIMD_WIDTH]; };
+#endif
+
+
+#pragma mark - Load/Store
+
+inline fsWide fs_wide_set1(fsr32 x) {
+#if FS_SIMD_AVX2
+    return {_mm256_set1_ps(x)};
+#elif FS_SIMD_SSE
+    return {_mm_set1_ps(x)};
+#elif FS_SIMD_NEON
+    return {vdupq_n_f32(x)};
+#else
+    fsWide r;
+    for (int i = 0; i < FS_SIMD_WIDTH; ++i) r.v[i] = x;
+    return r;
+#endif
+}
+
+/*! @brief Loads FS_SIMD_WIDTH floats from \c ptr, which needs no particular alignment. */
+inline fsWide fs_wide_load(const fsr32 *ptr) {
+#if FS_SIMD_AVX2
+    return {_mm256_loadu_ps(ptr)};
+#elif FS_SIMD_SSE
+    return {_mm_loadu_ps(ptr)};
+#elif FS_SIMD_NEON
+    return {vld1q_f32(ptr)};
+#else
+    fsWide r;
+    for (int i = 0; i < FS_SIMD_WIDTH; ++i) r.v[i] = ptr[i];
+    return r;
+#endif
+}
+
+inline void fs_wide_store(fsr32 *ptr, fsWide a) {
+#if FS_SIMD_AVX2
+    _mm256_storeu_ps(ptr, a.v);
+#elif FS_SIMD_SSE
+    _mm_storeu_ps(ptr, a.v);
+#elif FS_SIMD_NEON
+    vst1q_f32(ptr, a.v);
+#else
+    for (int i = 0; i < FS_SIMD_WIDTH; ++i) ptr[i] = a.v[i];
+#endif
+}
+
+inline fsWideInt fs_wide_int_set1(fsi32 x) {
+#if FS_SIMD_AVX2
+    return {_mm256_set1_epi32(x)};
+#elif FS_SIMD_SSE
+    return {_mm_set1_epi32(x)};
+#elif FS_SIMD_NEON
+    return {vdupq_n_s32(x)};
+#else
+    fsWideInt r;
+    for (int i = 0; i < FS_SIMD_WIDTH; ++i) r.v[i] = x;
+    return r;
+#endif
+}
+
+/*! @brief Loads FS_SIMD_WIDTH ints from \c ptr, which needs no particular alignment. */
+inline fsWideInt fs_wide_int_load(const fsi32 *ptr) {
+#if FS_SIMD_AVX2
+    return {_mm256_loadu_si256((const __m256i *)ptr)};
+#elif FS_SIMD_SSE
+    return {_mm_loadu_si128((const __m128i *)ptr)};
+#elif FS_SIMD_NEON
+    return {vld1q_s32(ptr)};
+#else
+    fsWideInt r;
+    for (int i = 0; i < FS_SIMD_WIDTH; ++i) r.v[i] = ptr[i];
+    return r;
+#endif
+}
+
+/*! @brief Returns {x, x + 1, ..., x + FS_SIMD_WIDTH - 1}. */
+inline fsWideInt fs_wide_int_ramp(fsi32 x) {
+#if FS_SIMD_AVX2
+    return {_mm256_add_epi32(_mm256_set1_epi32(x), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7))};
+#elif FS_SIMD_SSE
+    return {_mm_add_epi32(_mm_set1_epi32(x), _mm_setr_epi32(0, 1, 2, 3))};
+#elif FS_SIMD_NEON
+    const fsi32 ramp[4] = {0, 1, 2, 3};
+    return {vaddq_s32(vdupq_n_s32(x), vld1q_s32(ramp))};
+#else
+    fsWideInt r;
+    for (int i = 0; i < FS_SIMD_WIDTH; ++i) r.v[i] = x + i;
+    return r;
+#endif
+}
+
+inline void fs_wide_int_store(fsi32 *ptr, fsWideInt a) {
+#if FS_SIMD_AVX2
+    _mm256_storeu_si256((__m256i *)ptr, a.v);
+#elif FS_SIMD_SSE
+    _mm_storeu_si128((__m128i *)ptr, a.v);
+#elif FS_SIMD_NEON
+    vst1q_s32(ptr, a.v);
+#else
+    for (int i = 0; i < FS_SIMD_WIDTH; ++i) ptr[i] = a.v[i];
+#endif
+}
+
+
+#pragma mark - Arithmetic
+
+inline fsWide operator+(fsWide a, fsWide b) {
+#if FS_SIMD_AVX2
+    return {_mm256_add_ps(a.v, b.v)};
+#elif FS_SIMD_SSE
+    return {_mm_add_ps(a.v, b.v)};
+#elif FS_SIMD_NEON
+    return {vaddq_f32(a.v, b.v)};
+#else
+    fsWide r;
+    for (int i = 0; i < FS_SIMD_WIDTH; ++i) r.v[i] = a.v[i] + b.v[i];
+    return r;
+#endif
+}
+
+inline fsWide operator-(fsWide a, fsWide b) {
+#if FS_SIMD_AVX2
+    return {_mm256_sub_ps(a.v, b.v)};
+#elif FS_SIMD_SSE
+    return {_mm_sub_ps(a.v, b.v)};
+#elif FS_SIMD_NEON
+    return {vsubq_f32(a.v, b.v)};
+#else
+    fsWide r;
+    for (int i = 0; i < FS_SIMD_WIDTH; ++i) r.v[i] = a.v[i] - b.v[i];
+    return r;
+#endif
+}
+
+inline fsWide operator*(fsWide a, fsWide b) {
+#if FS_SIMD_AVX2
+    return {_mm256_mul_ps(a.v, b.v)};
+#elif FS_SIMD_SSE
+    return {_mm_mul_ps(a.v, b.v)};
+#elif FS_SIMD_NEON
+    return {vmulq_f32(a.v, b.v)};
+#else
+    fsWide r;
+    for (int i = 0; i < FS_SIMD_WIDTH; ++i) r.v[i] = a.v[i] * b.v[i];
+    return r;
+#endif
+}
+
+inline fsWide operator/(fsWide a, fsWide b) {
+#if FS_SIMD_AVX2
+    return {_mm256_div_ps(a.v, b.v)};
+#elif FS_SIMD_SSE
+    return {_mm_div_ps(a.v, b.v)};
+#elif FS_SIMD_NEON && defined(__aarch64__)
+    return {vdivq_f32(a.v, b.v)};
+#elif FS_SIMD_NEON
+    float32x4_t r = vrecpeq_f32(b.v);
+    r = vmulq_f32(vrecpsq_f32(b.v, r), r);
+    r = vmulq_f32(vrecpsq_f32(b.v, r), r);
+    return {vmulq_f32(a.v, r)};
+#else
+    fsWide r;
+    for (int i = 0; i < FS_SIMD_WIDTH; ++i) r.v[i] = a.v[i] / b.v[i];
+    return r;
+#endif
+}
+
+inline fsWide operator-(fsWide a) {
+    return fs_wide_set1(0.f) - a;
+}
+
+inline fsWide fs_wide_min(fsWide a, fsWide b) {
+#if FS_SIMD_AVX2
+    return {_mm256_min_ps(a.v, b.v)};
+#elif FS_SIMD_SSE
+    return {_mm_min_ps(a.v, b.v)};
+#elif FS_SIMD_NEON
+    return {vminq_f32(a.v, b.v)};
+#else
+    fsWide r;
+    for (int i = 0; i < FS_SIMD_WIDTH; ++i) r.v[i] = fsMin(a.v[i], b.v[i]);
+    return r;
+#endif
+}
+
+inline fsWide fs_wide_max(fsWide a, fsWide b) {
+#if FS_SIMD_AVX2
+    return {_mm256_max_ps(a.v, b.v)};
+#elif FS_SIMD_SSE
+    return {_mm_max_ps(a.v, b.v)};
+#elif FS_SIMD_NEON
+    return {vmaxq_f32(a.v, b.v)};
+#else
+    fsWide r;
+    for (int i = 0; i < FS_SIMD_WIDTH; ++i) r.v[i] = fsMax(a.v[i], b.v[i]);
+    return r;
+#endif
+}
+
+inline fsWide fs_wide_sqrt(fsWide a) {
+#if FS_SIMD_AVX2
+    return {_mm256_sqrt_ps(a.v)};
+#elif FS_SIMD_SSE
+    return {_mm_sqrt_ps(a.v)};
+#elif FS_SIMD_NEON && defined(__aarch64__)
+    return {vsqrtq_f32(a.v)};
+#else
+    fsWide r;
+    fsr32 in[FS_SIMD_WIDTH];
+    fs_wide_store(in, a);
+    for (int i = 0; i < FS_SIMD_WIDTH; ++i) in[i] = sqrtf(in[i]);
+    r = fs_wide_load(in);
+    return r;
+#endif
+}
+
+
+#pragma mark - Comparison & Selection
+
+inline fsWideMask operator<(fsWide a, fsWide b) {
+#if FS_SIMD_AVX2
+    return {_mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ)};
+#elif FS_SIMD_SSE
+    return {_mm_cmplt_ps(a.v, b.v)};
+#elif FS_SIMD_NEON
+    return {vcltq_f32(a.v, b.v)};
+#else
+    fsWideMask r;
+    for (int i = 0; i < FS_SIMD_WIDTH; ++i) r.v[i] = a.v[i] < b.v[i];
+    return r;
+#endif
+}
+
+inline fsWideMask operator>(fsWide a, fsWide b) {
+    return b < a;
+}
+
+inline fsWideMask operator>=(fsWide a, fsWide b) {
+#if FS_SIMD_AVX2
+    return {_mm256_cmp_ps(a.v, b.v, _CMP_GE_OQ)};
+#elif FS_SIMD_SSE
+    return {_mm_cmpge_ps(a.v, b.v)};
+#elif FS_SIMD_NEON
+    return {vcgeq_f32(a.v, b.v)};
+#else
+    fsWideMask r;
+    for (int i = 0; i < FS_SIMD_WIDTH; ++i) r.v[i] = a.v[i] >= b.v[i];
+    return r;
+#endif
+}
+
+inline fsWideMask operator==(fsWide a, fsWide b) {
+#if FS_SIMD_AVX2
+    return {_mm256_cmp_ps(a.v, b.v, _CMP_EQ_OQ)};
+#elif FS_SIMD_SSE
+    return {_mm_cmpeq_ps(a.v, b.v)};
+#elif FS_SIMD_NEON
+    return {vceqq_f32(a.v, b.v)};
+#else
+    fsWideMask r;
+    for (int i = 0; i < FS_SIMD_WIDTH; ++i) r.v[i] = a.v[i] == b.v[i];
+    return r;
+#endif
+}
+
+inline fsWideMask operator<(fsWideInt a, fsWideInt b) {
+#if FS_SIMD_AVX2
+    return {_mm256_castsi256_ps(_mm256_cmpgt_epi32(b.v, a.v))};
+#elif FS_SIMD_SSE
+    return {_mm_castsi128_ps(_mm_cmplt_epi32(a.v, b.v))};
+#elif FS_SIMD_NEON
+    return {vcltq_s32(a.v, b.v)};
+#else
+    fsWideMask r;
+    for (int i = 0; i < FS_SIMD_WIDTH; ++i) r.v[i] = a.v[i] < b.v[i];
+    return r;
+#endif
+}
+
+inline fsWideMask operator&(fsWideMask a, fsWideMask b) {
+#if FS_SIMD_AVX2
+    return {_mm256_and_ps(a.v, b.v)};
+#elif FS_SIMD_SSE
+    return {_mm_and_ps(a.v, b.v)};
+#elif FS_SIMD_NEON
+    return {vandq_u32(a.v, b.v)};
+#else
+    fsWideMask r;
+    for (int i = 0; i < FS_SIMD_WIDTH; ++i) r.v[i] = a.v[i] && b.v[i];
+    return r;
+#endif
+}
+
+inline fsWideMask operator|(fsWideMask a, fsWideMask b) {
+#if FS_SIMD_AVX2
+    return {_mm256_or_ps(a.v, b.v)};
+#elif FS_SIMD_SSE
+    return {_mm_or_ps(a.v, b.v)};
+#elif FS_SIMD_NEON
+    return {vorrq_u32(a.v, b.v)};
+#else
+    fsWideMask r;
+    for (int i = 0; i < FS_SIMD_WIDTH; ++i) r.v[i] = a.v[i] || b.v[i];
+    return r;
+#endif
+}
+
+/*! @brief Per lane, returns \c a where \c mask is set and \c b elsewhere. */
+inline fsWide fs_wide_select(fsWideMask mask, fsWide a, fsWide b) {
+#if FS_SIMD_AVX2
+    return {_mm256_blendv_ps(b.v, a.v, mask.v)};
+#elif FS_SIMD_SSE
+    return {_mm_or_ps(_mm_and_ps(mask.v, a.v), _mm_andnot_ps(mask.v, b.v))};
+#elif FS_SIMD_NEON
+    return {vbslq_f32(mask.v, a.v, b.v)};
+#else
+    fsWide r;
+    for (int i = 0; i < FS_SIMD_WIDTH; ++i) r.v[i] = mask.v[i] ? a.v[i] : b.v[i];
+    return r;
+#endif
+}
+
+/*! @brief Per lane, returns \c a where \c mask is set and \c b elsewhere. */
+inline fsWideInt fs_wide_select(fsWideMask mask, fsWideInt a, fsWideInt b) {
+#if FS_SIMD_AVX2
+    return {_mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(b.v), _mm256_castsi256_ps(a.v), mask.v))};
+#elif FS_SIMD_SSE
+    __m128i m = _mm_castps_si128(mask.v);
+    return {_mm_or_si128(_mm_and_si128(m, a.v), _mm_andnot_si128(m, b.v))};
+#elif FS_SIMD_NEON
+    return {vbslq_s32(mask.v, a.v, b.v)};
+#else
+    fsWideInt r;
+    for (int i = 0; i < FS_SIMD_WIDTH; ++i) r.v[i] = mask.v[i] ? a.v[i] : b.v[i];
+    return r;
+#endif
+}
+
+/*! @brief Returns a bit mask with bit \c i set if lane \c i of \c mask is set. */
+inline fsu32 fs_wide_movemask(fsWideMask mask) {
+#if FS_SIMD_AVX2
+    return (fsu32)_mm256_movemask_ps(mask.v);
+#elif FS_SIMD_SSE
+    return (fsu32)_mm_movemask_ps(mask.v);
+#elif FS_SIMD_NEON
+    const fsu32 bits[4] = {1, 2, 4, 8};
+    uint32x4_t m = vandq_u32(mask.v, vld1q_u32(bits));
+    return vgetq_lane_u32(m, 0) | vgetq_lane_u32(m, 1) | vgetq_lane_u32(m, 2) | vgetq_lane_u32(m, 3);
+#else
+    fsu32 r = 0;
+    for (int i = 0; i < FS_SIMD_WIDTH; ++i) r |= (mask.v[i] ? 1u : 0u) << i;
+    return r;
+#endif
+}
+
+/*! @brief Returns the smallest value across all lanes. */
+inline fsr32 fs_wide_hmin(fsWide a) {
+#if FS_SIMD_AVX2
+    __m128 m = _mm_min_ps(_mm256_castps256_ps128(a.v), _mm256_extractf128_ps(a.v, 1));
+    m = _mm_min_ps(m, _mm_movehl_ps(m, m));
+    m = _mm_min_ss(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(1, 1, 1, 1)));
+    return _mm_cvtss_f32(m);
+#elif FS_SIMD_SSE
+    __m128 m = _mm_min_ps(a.v, _mm_movehl_ps(a.v, a.v));
+    m = _mm_min_ss(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(1, 1, 1, 1)));
+    return _mm_cvtss_f32(m);
+#elif FS_SIMD_NEON && defined(__aarch64__)
+    return vminvq_f32(a.v);
+#else
+    fsr32 lanes[FS_SIMD_WIDTH];
+    fs_wide_store(lanes, a);
+    fsr32 r = lanes[0];
+    for (int i = 1; i < FS_SIMD_WIDTH; ++i) r = fsMin(r, lanes[i]);
+    return r;
+#endif
+}
+
+
+#pragma mark - Conversion & Bits
+
+/*! @brief Converts each lane to an integer, rounding toward zero. */
+inline fsWideInt fs_wide_to_int(fsWide a) {
+#if FS_SIMD_AVX2
+    return {_mm256_cvttps_epi32(a.v)};
+#elif FS_SIMD_SSE
+    return {_mm_cvttps_epi32(a.v)};
+#elif FS_SIMD_NEON
+    return {vcvtq_s32_f32(a.v)};
+#else
+    fsWideInt r;
+    for (int i = 0; i < FS_SIMD_WIDTH; ++i) r.v[i] = (fsi32)a.v[i];
+    return r;
+#endif
+}
+
+inline fsWideInt fs_wide_int_shl(fsWideInt a, int bits) {
+#if FS_SIMD_AVX2
+    return {_mm256_slli_epi32(a.v, bits)};
+#elif FS_SIMD_SSE
+    return {_mm_slli_epi32(a.v, bits)};
+#elif FS_SIMD_NEON
+    return {vshlq_s32(a.v, vdupq_n_s32(bits))};
+#else
+    fsWideInt r;
+    for (int i = 0; i < FS_SIMD_WIDTH; ++i) r.v[i] = (fsi32)((fsu32)a.v[i] << bits);
+    return r;
+#endif
+}
+
+inline fsWideInt operator|(fsWideInt a, fsWideInt b) {
+#if FS_SIMD_AVX2
+    return {_mm256_or_si256(a.v, b.v)};
+#elif FS_SIMD_SSE
+    return {_mm_or_si128(a.v, b.v)};
+#elif FS_SIMD_NEON
+    return {vorrq_s32(a.v, b.v)};
+#else
+    fsWideInt r;
+    for (int i = 0; i < FS_SIMD_WIDTH; ++i) r.v[i] = a.v[i] | b.v[i];
+    return r;
+#endif
+}
+
+
+#pragma mark - Half Precision
+
+/*! @brief Converts \c f to an IEEE 754 half, rounding to nearest even. Out-of-range values become infinity. */
+inline fsu16 fs_float_to_half(fsr32 f) {
+#if FS_SIMD_F16C
+    return (fsu16)_cvtss_sh(f, _MM_FROUND_TO_NEAREST_INT);
+#else
+    // NOTE: Bit manipulation after F. Giesen's float_to_half_fast3_rtne.
+    union { fsr32 f; fsu32 u; } x = {f};
+    fsu32 sign = x.u & 0x80000000u;
+    x.u ^= sign;
+    fsu16 h;
+    if (x.u >= 0x47800000u) {
+        h = (x.u > 0x7f800000u ? 0x7e00 : 0x7c00);
+    } else if (x.u < 0x38800000u) {
+        // Denormal or zero: let the float adder align the mantissa and do the rounding.
+        union { fsu32 u; fsr32 f; } magic = {((127 - 15) + (23 - 10) + 1) << 23};
+        x.f += magic.f;
+        h = (fsu16)(x.u - magic.u);
+    } else {
+        fsu32 mantissaOdd = (x.u >> 13) & 1;
+        x.u += ((fsu32)(15 - 127) << 23) + 0xfff + mantissaOdd;
+        h = (fsu16)(x.u >> 13);
+    }
+    return h | (fsu16)(sign >> 16);
+#endif
+}
+
+/*! @brief Converts the IEEE 754 half \c h to a float, exactly. */
+inline fsr32 fs_half_to_float(fsu16 h) {
+#if FS_SIMD_F16C
+    return _cvtsh_ss(h);
+#else
+    const fsu32 shiftedExponent = 0x7c00u << 13;
+    union { fsu32 u; fsr32 f; } x = {((fsu32)h & 0x7fffu) << 13};
+    fsu32 exponent = x.u & shiftedExponent;
+    x.u += (127 - 15) << 23;
+    if (exponent == shiftedExponent) {
+        x.u += (128 - 16) << 23;
+    } else if (exponent == 0) {
+        union { fsu32 u; fsr32 f; } magic = {113 << 23};
+        x.u += 1 << 23;
+        x.f -= magic.f;
+    }
+    x.u |= ((fsu32)h & 0x8000u) << 16;
+    return x.f;
+#endif
+}
+
+/*! @brief Converts four floats to halves; neither pointer needs any particular alignment. */
+inline void fs_float4_to_half4(const fsr32 *src, fsu16 *dst) {
+#if FS_SIMD_F16C
+    _mm_storel_epi64((__m128i *)dst, _mm_cvtps_ph(_mm_loadu_ps(src), _MM_FROUND_TO_NEAREST_INT));
+#elif FS_SIMD_NEON_F16
+    vst1_u16(dst, vreinterpret_u16_f16(vcvt_f16_f32(vld1q_f32(src))));
+#else
+    for (int i = 0; i < 4; ++i) dst[i] = fs_float_to_half(src[i]);
+#endif
+}
+
+/*! @brief Converts four halves to floats; neither pointer needs any particular alignment. */
+inline void fs_half4_to_float4(const fsu16 *src, fsr32 *dst) {
+#if FS_SIMD_F16C
+    _mm_storeu_ps(dst, _mm_cvtph_ps(_mm_loadl_epi64((const __m128i *)src)));
+#elif FS_SIMD_NEON_F16
+    vst1q_f32(dst, vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(src))));
+#else
+    for (int i = 0; i < 4; ++i) dst[i] = fs_half_to_float(src[i]);
+#endif
+}
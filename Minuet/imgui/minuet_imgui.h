@@ -17,14 +17,14 @@ extern "C" {
 
 struct mnScene;
 typedef struct mnScene mnScene;
-struct mnRenderer;
-typedef struct mnRenderer mnRenderer;
+struct mnRenderThread;
+typedef struct mnRenderThread mnRenderThread;
 struct mnPlatform;
 typedef struct mnPlatform mnPlatform;
 
 void mn_imgui_init(id<MTLDevice> device, NSView *view);
 void mn_imgui_shutdown();
-void mn_imgui_update(NSView *view, id<CAMetalDrawable> drawable, mnScene *scene, mnRenderer *renderer, mnPlatform *platform);
+void mn_imgui_update(NSView *view, id<CAMetalDrawable> drawable, mnScene *scene, mnRenderThread *renderThread, mnPlatform *platform);
 
 #ifdef __cplusplus
 }
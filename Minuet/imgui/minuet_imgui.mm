@@ -11,7 +11,7 @@
 #include "imgui_impl_osx.h"
 
 #include "minuet_scene.h"
-#include "minuet_renderer.h"
+#include "minuet_render_thread.h"
 
 #import <Cocoa/Cocoa.h>
 #import <QuartzCore/QuartzCore.h>
@@ -70,7 +70,7 @@ mn_imgui_shutdown() {
 }
 
 void
-mn_imgui_update(NSView *view, id<CAMetalDrawable> drawable, mnScene *scene, mnRenderer *renderer, mnPlatform *platform) {
+mn_imgui_update(NSView *view, id<CAMetalDrawable> drawable, mnScene *scene, mnRenderThread *renderThread, mnPlatform *platform) {
     id<MTLCommandBuffer> commandBuffer = commandQueue.commandBuffer;
     
     renderPassDescriptor.colorAttachments[0].texture = drawable.texture;
@@ -82,12 +82,90 @@ mn_imgui_update(NSView *view, id<CAMetalDrawable> drawable, mnScene *scene, mnRe
 
     {
         ImGui::Begin("Settings");
-        ImGui::Text("Last render: %.3fms", renderer->lastRenderTime);
+        mnRenderer::Settings& settings = renderThread->getSettings();
+        const mnRenderThread::Frame *frame = renderThread->getFrame();
+        static const mnRenderThread::Frame kNoFrame;
+        if (!frame) {
+            frame = &kNoFrame;
+        }
+        ImGui::Text("Last render: %.3fms", frame->renderTime);
+        const mnRenderStats& stats = frame->stats;
+        ImGui::Text("Rays: %llu", (unsigned long long)stats.rayCount);
+#if MN_STATS
+        if (stats.raysPerDepth[0] > 0 && stats.rayCount > 0) {
+            ImGui::Text("Rays/path: %.2f", (double)stats.rayCount / (double)stats.raysPerDepth[0]);
+            ImGui::Text("Sphere tests/ray: %.1f", (double)stats.sphereTests / (double)stats.rayCount);
+            ImGui::Text("Triangle tests/ray: %.1f", (double)stats.triangleTests / (double)stats.rayCount);
+            ImGui::Text("Escaped: %llu, bounce limit: %llu, roulette: %llu", (unsigned long long)stats.pathsEscaped,
+                        (unsigned long long)stats.pathsTerminatedByDepth, (unsigned long long)stats.pathsTerminatedByRoulette);
+        }
+#endif
         ImGui::Spacing();
         ImGui::Spacing();
-        ImGui::Checkbox("Accumulate", &renderer->getSettings().accumulate);
+        ImGui::Checkbox("Accumulate", &settings.accumulate);
+        ImGui::DragScalar("Threads", ImGuiDataType_U32, &settings.threadCount, 0.1f);
+        ImGui::Checkbox("Use BVH", &settings.useBVH);
+        ImGui::Checkbox("Primary ray packets", &settings.primaryRayPackets);
+        ImGui::Checkbox("Cache primary hits", &settings.cachePrimaryHits);
+        ImGui::Checkbox("Precomputed ray directions", &settings.precomputedRayDirections);
+        bool wavefront = (settings.executionMode == mnRenderer::ExecutionMode::wavefront);
+        if (ImGui::Checkbox("Wavefront", &wavefront)) {
+            settings.executionMode = (wavefront ? mnRenderer::ExecutionMode::wavefront : mnRenderer::ExecutionMode::megakernel);
+        }
+        ImGui::DragScalar("Max bounces", ImGuiDataType_U32, &settings.maxBounces, 0.1f);
+        ImGui::DragFloat("Sampling budget (ms)", &settings.frameTimeBudget, 0.1f, 0.f, 100.f, "%.1f");
+        if (settings.frameTimeBudget > 0.f) {
+            ImGui::Text("Passes: %u", frame->passCount);
+        }
+        static const char *kSamplerNames[] = {"Random", "Stratified", "Sobol (Owen)", "Blue noise"};
+        int samplerType = (int)settings.samplerType;
+        if (ImGui::Combo("Sampler", &samplerType, kSamplerNames, IM_ARRAYSIZE(kSamplerNames))) {
+            settings.samplerType = (mnSamplerType)samplerType;
+            renderThread->resetAccumulation();
+        }
+        static const char *kToneMapperNames[] = {"Clamp", "Reinhard", "ACES"};
+        int toneMapper = (int)settings.toneMapper;
+        if (ImGui::Combo("Tone mapper", &toneMapper, kToneMapperNames, IM_ARRAYSIZE(kToneMapperNames))) {
+            settings.toneMapper = (mnToneMapper)toneMapper;
+        }
+        static const char *kAccumulationNames[] = {"RGBA32F", "RGB32F", "RGBA16F"};
+        int accumulationFormat = (int)settings.accumulationFormat;
+        if (ImGui::Combo("Accumulation", &accumulationFormat, kAccumulationNames, IM_ARRAYSIZE(kAccumulationNames))) {
+            settings.accumulationFormat = (mnRenderer::AccumulationFormat)accumulationFormat;
+            renderThread->resetAccumulation();
+        }
+        ImGui::Checkbox("Sample lights (NEE)", &settings.nextEventEstimation);
+        ImGui::Checkbox("Adaptive sampling", &settings.adaptiveSampling);
+        if (settings.adaptiveSampling) {
+            ImGui::DragFloat("Noise threshold", &settings.adaptiveThreshold, 0.001f, 0.001f, 1.f, "%.3f");
+            ImGui::DragScalar("Min samples", ImGuiDataType_U32, &settings.adaptiveMinSamples, 0.1f);
+            ImGui::DragScalar("Max boost", ImGuiDataType_U32, &settings.adaptiveMaxBoost, 0.1f);
+            ImGui::Text("Converged pixels: %u", frame->convergedPixelCount);
+        }
+        ImGui::Checkbox("Temporal reprojection", &settings.temporalReprojection);
+        if (settings.temporalReprojection) {
+            ImGui::DragFloat("Max history", &settings.reprojectionMaxHistory, 0.1f, 1.f, 256.f, "%.1f");
+            ImGui::DragFloat("Depth tolerance", &settings.reprojectionDepthTolerance, 0.001f, 0.001f, 1.f, "%.3f");
+        }
+        ImGui::Checkbox("Dynamic resolution", &settings.dynamicResolution);
+        if (settings.dynamicResolution) {
+            ImGui::DragFloat("Frame budget (ms)", &settings.dynamicResolutionBudget, 0.1f, 1.f, 100.f, "%.1f");
+            ImGui::DragFloat("Min scale", &settings.dynamicResolutionMinScale, 0.01f, 0.05f, 1.f, "%.2f");
+            ImGui::DragFloat("Edge tolerance", &settings.dynamicResolutionDepthTolerance, 0.001f, 0.001f, 1.f, "%.3f");
+            ImGui::Text("Resolution scale: %.2f", frame->resolutionScale);
+        }
+        ImGui::Checkbox("Russian roulette", &settings.russianRoulette);
+        if (settings.russianRoulette) {
+            ImGui::DragScalar("Roulette min bounces", ImGuiDataType_U32, &settings.rouletteMinBounces, 0.1f);
+            ImGui::DragFloatRange2("Survival clamp", &settings.rouletteMinSurvival,
+                                   &settings.rouletteMaxSurvival, 0.01f, 0.01f, 1.f);
+        }
+        bool rebuildBVH = (settings.bvhUpdateMode == mnBVH::UpdateMode::rebuild);
+        if (ImGui::Checkbox("Rebuild BVH on edit", &rebuildBVH)) {
+            settings.bvhUpdateMode = (rebuildBVH ? mnBVH::UpdateMode::rebuild : mnBVH::UpdateMode::refit);
+        }
         if (ImGui::Button("Reset")) {
-            renderer->resetFrameIndex();
+            renderThread->resetAccumulation();
         }
         ImGui::Spacing();
         ImGui::Separator();
@@ -98,28 +176,46 @@ mn_imgui_update(NSView *view, id<CAMetalDrawable> drawable, mnScene *scene, mnRe
         ImGui::End();
         
         ImGui::Begin("Scene");
-        for (int i = 0; i < scene->spheres.size(); ++i) {
-            mnSphere& sphere = scene->spheres[i];
+        // NOTE(christian): Widgets edit copies read through the const scene, and only an edited element is written back through
+        // the non-const accessors, which copy a mapped scene's arrays out of the mapping.
+        const mnScene& viewedScene = *scene;
+        bool sceneEdited = false;
+        for (int i = 0; i < viewedScene.spheres.size(); ++i) {
+            mnSphere sphere = viewedScene.spheres[i];
             
             ImGui::PushID(i);
-            ImGui::DragFloat3("Position", sphere.position.e, 0.1f);
-            ImGui::DragFloat("Radius", &sphere.radius, 0.1f);
-            ImGui::DragInt("Material", &sphere.materialIndex, 1.f, 0, (int)scene->materials.size() - 1);
+            bool edited = ImGui::DragFloat3("Position", sphere.position.e, 0.1f);
+            edited |= ImGui::DragFloat("Radius", &sphere.radius, 0.1f);
+            edited |= ImGui::DragInt("Material", &sphere.materialIndex, 1.f, 0, (int)viewedScene.materials.size() - 1);
             ImGui::Separator();
             ImGui::PopID();
+            
+            if (edited) {
+                scene->spheres[i] = sphere;
+                sceneEdited = true;
+            }
         }
         
-        for (int i = 0; i < scene->materials.size(); ++i) {
-            mnMaterial& material = scene->materials[i];
+        for (int i = 0; i < viewedScene.materials.size(); ++i) {
+            mnMaterial material = viewedScene.materials[i];
             
             ImGui::PushID(i);
-            ImGui::ColorEdit3("Albedo", material.albedo.e);
-            ImGui::DragFloat("Roughness", &material.roughness, 0.05f, 0.f, 1.f);
-            ImGui::DragFloat("Metallic", &material.metallic, 0.05f, 0.f, 1.f);
-            ImGui::ColorEdit3("Emission Color", material.emissionColor.e);
-            ImGui::DragFloat("Emission Power", &material.emissionPower, 0.05f, 0.f, FLT_MAX);
+            bool edited = ImGui::ColorEdit3("Albedo", material.albedo.e);
+            edited |= ImGui::DragFloat("Roughness", &material.roughness, 0.05f, 0.f, 1.f);
+            edited |= ImGui::DragFloat("Metallic", &material.metallic, 0.05f, 0.f, 1.f);
+            edited |= ImGui::ColorEdit3("Emission Color", material.emissionColor.e);
+            edited |= ImGui::DragFloat("Emission Power", &material.emissionPower, 0.05f, 0.f, FLT_MAX);
             ImGui::Separator();
             ImGui::PopID();
+            
+            if (edited) {
+                scene->materials[i] = material;
+                sceneEdited = true;
+            }
+        }
+        
+        if (sceneEdited) {
+            scene->revision++;
         }
         ImGui::End();
     }
@@ -0,0 +1,145 @@
+//
+//  minuet_bsdf.cpp
+//  Minuet
+//
+//  Created by Christian Floisand on 2026-10-16.
+//
+
+#include "minuet_bsdf.h"
+
+
+// NOTE(christian): Below this width the lobe is so peaked that a single evaluation toward a light can produce a huge value,
+// so mirror-like materials are treated as very slightly rough.
+static const fsr32 kMinAlpha = 0.01f;
+
+static inline fsr32
+luminance(const fsv3f& color) {
+    return 0.2126f * color.r + 0.7152f * color.g + 0.0722f * color.b;
+}
+
+static inline fsv3f
+fresnelSchlick(const fsv3f& f0, fsr32 cosTheta) {
+    fsr32 m = 1.f - fsClamp(cosTheta, 0.f, 1.f);
+    fsr32 m5 = (m * m) * (m * m) * m;
+    return f0 + ((fsv3f){1.f, 1.f, 1.f} - f0) * m5;
+}
+
+/*! @brief GGX normal distribution for a local half vector \c h. */
+static inline fsr32
+ggxD(const fsv3f& h, fsr32 alpha) {
+    fsr32 alphaSq = alpha * alpha;
+    fsr32 d = h.z * h.z * (alphaSq - 1.f) + 1.f;
+    return alphaSq / (fsPi32 * d * d);
+}
+
+/*! @brief Smith's Lambda for GGX, for a local direction \c v above the surface. */
+static inline fsr32
+ggxLambda(const fsv3f& v, fsr32 alpha) {
+    fsr32 cosSq = v.z * v.z;
+    fsr32 tanSq = fsMax(1.f - cosSq, 0.f) / cosSq;
+    return 0.5f * (sqrtf(1.f + alpha * alpha * tanSq) - 1.f);
+}
+
+
+#pragma mark - mnBSDF
+
+mnBSDF::mnBSDF(const mnMaterial& material, const fsv3f& normal, const fsv3f& outgoing) {
+    _normal = normal;
+    mn_make_basis(normal, _tangent, _bitangent);
+    _outgoing = toLocal(outgoing);
+    
+    fsr32 metallic = fsClamp(material.metallic, 0.f, 1.f);
+    fsr32 roughness = fsClamp(material.roughness, 0.f, 1.f);
+    _alpha = fsMax(roughness * roughness, kMinAlpha);
+    _specular = (fsv3f){0.04f, 0.04f, 0.04f} * (1.f - metallic) + material.albedo * metallic;
+    
+    // NOTE(christian): Light the specular lobe reflects at this viewing angle doesn't reach the diffuse layer. This keeps
+    // the sum from reflecting more than it receives, without the cost of an exact energy-conserving model.
+    fsv3f fresnel = fresnelSchlick(_specular, _outgoing.z);
+    _diffuse = fs_vhadamard(material.albedo * (1.f - metallic), (fsv3f){1.f, 1.f, 1.f} - fresnel);
+    
+    fsr32 specularWeight = luminance(fresnel);
+    fsr32 diffuseWeight = luminance(_diffuse);
+    _specularProbability = (specularWeight + diffuseWeight > 0.f ? specularWeight / (specularWeight + diffuseWeight) : 1.f);
+}
+
+bool
+mnBSDF::sample(fsr32 uLobe, fsr32 u1, fsr32 u2, mnBSDFSample& result) const {
+    const fsv3f& out = _outgoing;
+    if (out.z <= 0.f) {
+        return false;
+    }
+    
+    fsv3f in;
+    if (uLobe < _specularProbability) {
+        // Visible normal sampling (Heitz 2018): stretch to the unit-roughness configuration, sample the projected
+        // hemisphere as seen from the outgoing direction, and unstretch.
+        fsv3f stretched = fs_vnormalize((fsv3f){_alpha * out.x, _alpha * out.y, out.z});
+        fsr32 lengthSq = stretched.x * stretched.x + stretched.y * stretched.y;
+        fsv3f t1 = (lengthSq > 0.f ? (fsv3f){-stretched.y, stretched.x, 0.f} * (1.f / sqrtf(lengthSq)) : (fsv3f){1.f, 0.f, 0.f});
+        fsv3f t2 = fs_vcross(stretched, t1);
+        fsr32 r = sqrtf(u1);
+        fsr32 phi = fsTau32 * u2;
+        fsr32 p1 = r * cosf(phi);
+        fsr32 p2 = r * sinf(phi);
+        fsr32 s = 0.5f * (1.f + stretched.z);
+        p2 = (1.f - s) * sqrtf(fsMax(0.f, 1.f - p1 * p1)) + s * p2;
+        fsv3f h = t1 * p1 + t2 * p2 + stretched * sqrtf(fsMax(0.f, 1.f - p1 * p1 - p2 * p2));
+        h = fs_vnormalize((fsv3f){_alpha * h.x, _alpha * h.y, fsMax(h.z, 0.f)});
+        in = h * (2.f * fs_vdot(out, h)) - out;
+    } else {
+        fsr32 r = sqrtf(u1);
+        fsr32 phi = fsTau32 * u2;
+        in = {r * cosf(phi), r * sinf(phi), sqrtf(fsMax(0.f, 1.f - u1))};
+    }
+    
+    if (in.z <= 0.f) {
+        return false;
+    }
+    
+    fsr32 pdf;
+    fsv3f value = evaluateLocal(in, pdf);
+    if (pdf <= 0.f) {
+        return false;
+    }
+    
+    result.direction = toWorld(in);
+    result.weight = value * (1.f / pdf);
+    result.pdf = pdf;
+    return true;
+}
+
+fsv3f
+mnBSDF::evaluate(const fsv3f& direction, fsr32& pdf) const {
+    fsv3f in = toLocal(direction);
+    if (in.z <= 0.f || _outgoing.z <= 0.f) {
+        pdf = 0.f;
+        return {};
+    }
+    return evaluateLocal(in, pdf);
+}
+
+fsv3f
+mnBSDF::evaluateLocal(const fsv3f& in, fsr32& pdf) const {
+    const fsv3f& out = _outgoing;
+    
+    fsr32 diffusePdf = in.z / fsPi32;
+    fsv3f value = _diffuse * diffusePdf;
+    pdf = (1.f - _specularProbability) * diffusePdf;
+    
+    if (_specularProbability > 0.f) {
+        fsv3f h = fs_vnormalize(in + out);
+        fsr32 d = ggxD(h, _alpha);
+        fsr32 lambdaOut = ggxLambda(out, _alpha);
+        fsr32 lambdaIn = ggxLambda(in, _alpha);
+        
+        // Height-correlated masking-shadowing; the visible normal pdf only has the masking of the outgoing direction.
+        fsr32 g2 = 1.f / (1.f + lambdaOut + lambdaIn);
+        fsr32 g1 = 1.f / (1.f + lambdaOut);
+        fsr32 specularPdf = g1 * d / (4.f * out.z);
+        value += fresnelSchlick(_specular, fs_vdot(in, h)) * (d * g2 / (4.f * out.z));
+        pdf += _specularProbability * specularPdf;
+    }
+    
+    return value;
+}
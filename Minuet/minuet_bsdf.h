@@ -0,0 +1,59 @@
+//
+//  minuet_bsdf.h
+//  Minuet
+//
+//  Created by Christian Floisand on 2026-10-16.
+//
+
+#pragma once
+#include "minuet_platform.h"
+#include "minuet_scene.h"
+
+
+/*! @brief Builds two unit vectors perpendicular to the unit vector \c n and to each other (Duff et al. 2017). */
+inline void
+mn_make_basis(const fsv3f& n, fsv3f& tangent, fsv3f& bitangent) {
+    fsr32 sign = copysignf(1.f, n.z);
+    fsr32 a = -1.f / (sign + n.z);
+    fsr32 b = n.x * n.y * a;
+    tangent = {1.f + sign * n.x * n.x * a, sign * b, -sign * n.x};
+    bitangent = {b, sign + n.y * n.y * a, -n.y};
+}
+
+
+#pragma mark - mnBSDF
+
+struct mnBSDFSample {
+    fsv3f direction;
+    fsv3f weight;   // BSDF * cos / pdf: what the path throughput is multiplied by
+    fsr32 pdf;      // Solid angle pdf of the direction, over both lobes
+};
+
+/*! @brief The scattering function of \c mnMaterial at one surface point, seen from one direction. It's a Lambertian lobe
+    for the diffuse color (albedo, fading out as metallic goes to 1) plus a GGX microfacet lobe with Schlick Fresnel,
+    whose reflectance at normal incidence goes from 4% to the albedo with metallic and whose width is roughness^2.
+    Directions point away from the surface. */
+struct mnBSDF {
+    mnBSDF(const mnMaterial& material, const fsv3f& normal, const fsv3f& outgoing);
+    
+    /*! @brief Picks a lobe with \c uLobe and samples a direction from it with \c u1 and \c u2: cosine-weighted for the
+        diffuse lobe, and from the distribution of visible normals for the specular one. Returns false if the sample is
+        below the surface or the surface is seen from behind. */
+    bool sample(fsr32 uLobe, fsr32 u1, fsr32 u2, mnBSDFSample& result) const;
+    /*! @brief BSDF * cos toward \c direction, and in \c pdf the density with which \c sample would have picked it. */
+    fsv3f evaluate(const fsv3f& direction, fsr32& pdf) const;
+
+private:
+    fsv3f toLocal(const fsv3f& v) const { return {fs_vdot(v, _tangent), fs_vdot(v, _bitangent), fs_vdot(v, _normal)}; }
+    fsv3f toWorld(const fsv3f& v) const { return _tangent * v.x + _bitangent * v.y + _normal * v.z; }
+    /*! @brief Both lobes toward the local direction \c in, with their combined pdf. */
+    fsv3f evaluateLocal(const fsv3f& in, fsr32& pdf) const;
+
+private:
+    fsv3f _normal, _tangent, _bitangent;
+    fsv3f _outgoing;        // In the local frame, where the normal is +z
+    fsv3f _diffuse;         // Lambertian reflectance, already scaled down by the light the specular lobe reflects
+    fsv3f _specular;        // Fresnel reflectance at normal incidence
+    fsr32 _alpha;           // GGX width
+    fsr32 _specularProbability;
+};
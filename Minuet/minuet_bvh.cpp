@@ -0,0 +1,295 @@
+//
+//  minuet_bvh.cpp
+//  Minuet
+//
+//  Created by Christian Floisand on 2026-10-16.
+//
+
+#include "minuet_bvh.h"
+#include "fs_simd.h"
+#include <algorithm>
+
+
+// NOTE(christian): Past this depth subdivision falls back to object-median splits, which keeps the tree shallow enough for the
+// fixed-size traversal stack even when SAH keeps peeling off one sphere at a time.
+static const fsu32 kMaxSAHDepth = 40;
+
+static inline mnAABB
+sphereBounds(const mnSphere& sphere) {
+    fsv3f r = {sphere.radius, sphere.radius, sphere.radius};
+    mnAABB box;
+    box.min = sphere.position - r;
+    box.max = sphere.position + r;
+    return box;
+}
+
+static inline mnAABB
+triangleBounds(const mnMesh& mesh, fsu32 triangle) {
+    mnAABB box;
+    box.grow(mesh.getVertex(mesh.indices[triangle * 3 + 0]));
+    box.grow(mesh.getVertex(mesh.indices[triangle * 3 + 1]));
+    box.grow(mesh.getVertex(mesh.indices[triangle * 3 + 2]));
+    return box;
+}
+
+static inline fsr32
+simdCost(fsu32 count) {
+    return (fsr32)((count + FS_SIMD_WIDTH - 1) / FS_SIMD_WIDTH);
+}
+
+static inline fsu32
+binIndex(fsr32 centroid, fsr32 centroidMin, fsr32 binScale) {
+    fsi32 bin = (fsi32)((centroid - centroidMin) * binScale);
+    return (fsu32)fsClamp(bin, 0, (fsi32)mnBVH::kBinCount - 1);
+}
+
+
+#pragma mark - mnBVH
+
+void
+mnBVH::build(const mnScene& scene) {
+    fsu32 count = (fsu32)scene.spheres.size();
+    _bounds.resize(count);
+    _centroids.resize(count);
+    for (fsu32 i = 0; i < count; ++i) {
+        _bounds[i] = sphereBounds(scene.spheres[i]);
+        _centroids[i] = scene.spheres[i].position;
+    }
+    buildFromBounds();
+}
+
+void
+mnBVH::build(const mnMesh& mesh) {
+    fsu32 count = mesh.getTriangleCount();
+    _bounds.resize(count);
+    _centroids.resize(count);
+    for (fsu32 i = 0; i < count; ++i) {
+        _bounds[i] = triangleBounds(mesh, i);
+        _centroids[i] = (_bounds[i].min + _bounds[i].max) * 0.5f;
+    }
+    buildFromBounds();
+}
+
+void
+mnBVH::refit(const mnScene& scene) {
+    fsAssert(primitiveIndices.size() == scene.spheres.size());
+    
+    _bounds.resize(scene.spheres.size());
+    for (fsu32 i = 0; i < scene.spheres.size(); ++i) {
+        _bounds[i] = sphereBounds(scene.spheres[i]);
+    }
+    refitFromBounds();
+}
+
+void
+mnBVH::refit(const mnMesh& mesh) {
+    fsAssert(primitiveIndices.size() == mesh.getTriangleCount());
+    
+    _bounds.resize(mesh.getTriangleCount());
+    for (fsu32 i = 0; i < mesh.getTriangleCount(); ++i) {
+        _bounds[i] = triangleBounds(mesh, i);
+    }
+    refitFromBounds();
+}
+
+void
+mnBVH::buildFromBounds() {
+    clear();
+    
+    fsu32 count = (fsu32)_bounds.size();
+    if (count == 0) {
+        return;
+    }
+    
+    primitiveIndices.resize(count);
+    for (fsu32 i = 0; i < count; ++i) {
+        primitiveIndices[i] = i;
+    }
+    
+    // NOTE(christian): A tree over N primitives has at most 2N - 1 nodes. Slot 1 is left unused so that every sibling pair
+    // starts on an even index, and since the nodes are 32 bytes and allocated on a 64-byte boundary, the two children share
+    // a cache line.
+    nodes.reserve(2 * count);
+    
+    mnBVHNode root;
+    root.leftFirst = 0;
+    root.primitiveCount = count;
+    nodes.push_back(root);
+    nodes.push_back(mnBVHNode{});
+    
+    updateNodeBounds(nodes[0]);
+    subdivide(0, 0);
+}
+
+void
+mnBVH::refitFromBounds() {
+    for (fsi64 i = (fsi64)nodes.size() - 1; i >= 0; --i) {
+        if (i == 1) {
+            continue;
+        }
+        
+        mnBVHNode& node = nodes[i];
+        if (node.isLeaf()) {
+            updateNodeBounds(node);
+        } else {
+            const mnBVHNode& left = nodes[node.leftFirst];
+            const mnBVHNode& right = nodes[node.leftFirst + 1];
+            node.boundsMin = {fsMin(left.boundsMin.x, right.boundsMin.x), fsMin(left.boundsMin.y, right.boundsMin.y), fsMin(left.boundsMin.z, right.boundsMin.z)};
+            node.boundsMax = {fsMax(left.boundsMax.x, right.boundsMax.x), fsMax(left.boundsMax.y, right.boundsMax.y), fsMax(left.boundsMax.z, right.boundsMax.z)};
+        }
+    }
+}
+
+void
+mnBVH::clear() {
+    nodes.clear();
+    primitiveIndices.clear();
+}
+
+void
+mnBVH::updateNodeBounds(mnBVHNode& node) {
+    mnAABB bounds;
+    for (fsu32 i = 0; i < node.primitiveCount; ++i) {
+        bounds.grow(_bounds[primitiveIndices[node.leftFirst + i]]);
+    }
+    
+    node.boundsMin = bounds.min;
+    node.boundsMax = bounds.max;
+}
+
+void
+mnBVH::subdivide(fsu32 nodeIndex, fsu32 depth) {
+    mnBVHNode node = nodes[nodeIndex];
+    fsu32 first = node.leftFirst;
+    fsu32 count = node.primitiveCount;
+    if (count <= 1) {
+        return;
+    }
+    
+    fsu32 leftCount = 0;
+    Split split;
+    fsr32 splitCost = (depth < kMaxSAHDepth ? findBestSplit(node, split) : FLT_MAX);
+    
+    if (splitCost < FLT_MAX) {
+        // NOTE(christian): SAH costs are relative to the parent's surface area, with a traversal step costing as much as one
+        // ray-sphere test. Leaves are only forced to split once they exceed the maximum leaf size.
+        fsr32 leafCost = simdCost(count);
+        if (splitCost >= leafCost && count <= kMaxLeafSize) {
+            return;
+        }
+        
+        fsu32 *begin = primitiveIndices.data() + first;
+        fsu32 *middle = std::partition(begin, begin + count, [&](fsu32 prim) {
+            return binIndex(_centroids[prim].e[split.axis], split.centroidMin, split.binScale) <= split.bin;
+        });
+        leftCount = (fsu32)(middle - begin);
+    } else if (count <= kMaxLeafSize) {
+        return;
+    }
+    
+    if (leftCount == 0 || leftCount == count) {
+        // Object-median split along the longest axis of the node.
+        fsv3f extent = node.boundsMax - node.boundsMin;
+        fsi32 axis = (extent.y > extent.x ? 1 : 0);
+        if (extent.z > extent.e[axis]) {
+            axis = 2;
+        }
+        
+        leftCount = count / 2;
+        fsu32 *begin = primitiveIndices.data() + first;
+        std::nth_element(begin, begin + leftCount, begin + count, [&](fsu32 a, fsu32 b) {
+            return _centroids[a].e[axis] < _centroids[b].e[axis];
+        });
+    }
+    
+    fsu32 leftIndex = (fsu32)nodes.size();
+    
+    mnBVHNode left;
+    left.leftFirst = first;
+    left.primitiveCount = leftCount;
+    mnBVHNode right;
+    right.leftFirst = first + leftCount;
+    right.primitiveCount = count - leftCount;
+    
+    nodes.push_back(left);
+    nodes.push_back(right);
+    updateNodeBounds(nodes[leftIndex]);
+    updateNodeBounds(nodes[leftIndex + 1]);
+    
+    nodes[nodeIndex].leftFirst = leftIndex;
+    nodes[nodeIndex].primitiveCount = 0;
+    
+    subdivide(leftIndex, depth + 1);
+    subdivide(leftIndex + 1, depth + 1);
+}
+
+fsr32
+mnBVH::findBestSplit(const mnBVHNode& node, Split& split) {
+    struct Bin {
+        mnAABB bounds;
+        fsu32 count = 0;
+    };
+    
+    mnAABB parentBounds;
+    parentBounds.min = node.boundsMin;
+    parentBounds.max = node.boundsMax;
+    fsr32 parentArea = fsMax(parentBounds.halfArea(), FLT_MIN);
+    fsr32 bestCost = FLT_MAX;
+    
+    for (fsi32 axis = 0; axis < 3; ++axis) {
+        fsr32 centroidMin = FLT_MAX;
+        fsr32 centroidMax = -FLT_MAX;
+        for (fsu32 i = 0; i < node.primitiveCount; ++i) {
+            fsr32 c = _centroids[primitiveIndices[node.leftFirst + i]].e[axis];
+            centroidMin = fsMin(centroidMin, c);
+            centroidMax = fsMax(centroidMax, c);
+        }
+        
+        if (centroidMax <= centroidMin) {
+            continue;
+        }
+        
+        Bin bins[kBinCount];
+        fsr32 binScale = (fsr32)kBinCount / (centroidMax - centroidMin);
+        for (fsu32 i = 0; i < node.primitiveCount; ++i) {
+            fsu32 prim = primitiveIndices[node.leftFirst + i];
+            Bin& bin = bins[binIndex(_centroids[prim].e[axis], centroidMin, binScale)];
+            bin.bounds.grow(_bounds[prim]);
+            bin.count++;
+        }
+        
+        // Sweep from both ends to get the area and count on either side of each of the kBinCount - 1 candidate planes.
+        fsr32 leftArea[kBinCount - 1], rightArea[kBinCount - 1];
+        fsu32 leftCount[kBinCount - 1], rightCount[kBinCount - 1];
+        mnAABB leftBox, rightBox;
+        fsu32 leftSum = 0, rightSum = 0;
+        for (fsu32 i = 0; i < kBinCount - 1; ++i) {
+            leftSum += bins[i].count;
+            leftCount[i] = leftSum;
+            leftBox.grow(bins[i].bounds);
+            leftArea[i] = leftBox.halfArea();
+            
+            rightSum += bins[kBinCount - 1 - i].count;
+            rightCount[kBinCount - 2 - i] = rightSum;
+            rightBox.grow(bins[kBinCount - 1 - i].bounds);
+            rightArea[kBinCount - 2 - i] = rightBox.halfArea();
+        }
+        
+        for (fsu32 i = 0; i < kBinCount - 1; ++i) {
+            if (leftCount[i] == 0 || rightCount[i] == 0) {
+                continue;
+            }
+            
+            fsr32 cost = 1.f + (simdCost(leftCount[i]) * leftArea[i] + simdCost(rightCount[i]) * rightArea[i]) / parentArea;
+            if (cost < bestCost) {
+                bestCost = cost;
+                split.axis = axis;
+                split.bin = i;
+                split.centroidMin = centroidMin;
+                split.binScale = binScale;
+            }
+        }
+    }
+    
+    return bestCost;
+}
@@ -0,0 +1,239 @@
+//
+//  minuet_bvh.h
+//  Minuet
+//
+//  Created by Christian Floisand on 2026-10-16.
+//
+
+#pragma once
+#include "minuet_platform.h"
+#include "minuet_ray.h"
+#include "minuet_ray_packet.h"
+#include "minuet_scene.h"
+#include <vector>
+
+
+#pragma mark - mnAABB
+
+struct mnAABB {
+    fsv3f min = {FLT_MAX, FLT_MAX, FLT_MAX};
+    fsv3f max = {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+    
+    void grow(const fsv3f& p) {
+        min = {fsMin(min.x, p.x), fsMin(min.y, p.y), fsMin(min.z, p.z)};
+        max = {fsMax(max.x, p.x), fsMax(max.y, p.y), fsMax(max.z, p.z)};
+    }
+    
+    void grow(const mnAABB& box) {
+        if (box.min.x != FLT_MAX) {
+            grow(box.min);
+            grow(box.max);
+        }
+    }
+    
+    fsr32 halfArea() const {
+        fsv3f e = max - min;
+        return e.x * e.y + e.y * e.z + e.z * e.x;
+    }
+};
+
+
+#pragma mark - mnBVHNode
+
+/*! @brief A 32-byte BVH node. Children are allocated in adjacent pairs, so an interior node only stores the index of its left
+    child; the right child is always at \c leftFirst + 1. For leaves, \c leftFirst is the first entry in the BVH's primitive
+    index list and \c primitiveCount is non-zero. */
+struct mnBVHNode {
+    fsv3f boundsMin;
+    fsu32 leftFirst;
+    fsv3f boundsMax;
+    fsu32 primitiveCount;
+    
+    bool isLeaf() const { return primitiveCount > 0; }
+};
+static_assert(sizeof(mnBVHNode) == 32, "mnBVHNode must stay 32 bytes for sibling pairs to share a cache line.");
+
+
+#pragma mark - mnBVH
+
+/*! @brief Bounding volume hierarchy over the spheres of an \c mnScene or the triangles of an \c mnMesh, built with binned SAH. */
+struct mnBVH {
+    
+    enum struct UpdateMode {
+        refit,      // Keep the topology, recompute node bounds bottom-up. Fast, but quality degrades with large motion.
+        rebuild     // Rebuild from scratch.
+    };
+    
+    static const fsu32 kBinCount = 12;
+    static const fsu32 kMaxLeafSize = 8;
+    
+    /*! @brief Builds the hierarchy from scratch over all spheres in \c scene. */
+    void build(const mnScene& scene);
+    /*! @brief Builds the hierarchy from scratch over all triangles in \c mesh. */
+    void build(const mnMesh& mesh);
+    /*! @brief Recomputes node bounds from the current sphere positions and radii without changing the tree topology.
+        The scene must contain the same spheres the hierarchy was built with. */
+    void refit(const mnScene& scene);
+    /*! @brief Recomputes node bounds from the current vertex positions. The mesh must have the same triangles the hierarchy
+        was built with. */
+    void refit(const mnMesh& mesh);
+    
+    void clear();
+    bool isEmpty() const { return nodes.empty(); }
+    
+    /*! @brief Walks the hierarchy front-to-back along \c ray, calling \c intersectLeaf(first, count, hitDistance) for every
+        leaf whose bounds are entered before \c hitDistance. The callback updates \c hitDistance when it finds a closer hit,
+        and returns true to stop traversal early (e.g. for occlusion queries). */
+    template <typename LeafFunc>
+    void traverse(const mnRay& ray, fsr32& hitDistance, LeafFunc&& intersectLeaf) const;
+    /*! @brief Packet version of \c traverse. Nodes are culled against the whole packet with interval bounds, and \c intersectLeaf
+        (first, count) is called for every leaf that some ray may enter before the packet's farthest current hit. */
+    template <typename LeafFunc>
+    void traversePacket(const mnRayPacket& packet, LeafFunc&& intersectLeaf) const;
+
+public:
+    std::vector<mnBVHNode, fsAlignedAllocator<mnBVHNode, 64>> nodes;   // Cache line aligned, see buildFromBounds
+    std::vector<fsu32> primitiveIndices;
+
+private:
+    struct Split {
+        fsi32 axis;
+        fsu32 bin;
+        fsr32 centroidMin;
+        fsr32 binScale;
+    };
+    
+    /*! @brief Builds over the primitive bounds and centroids in \c _bounds and \c _centroids. */
+    void buildFromBounds();
+    void refitFromBounds();
+    void updateNodeBounds(mnBVHNode& node);
+    void subdivide(fsu32 nodeIndex, fsu32 depth);
+    fsr32 findBestSplit(const mnBVHNode& node, Split& split);
+
+private:
+    std::vector<mnAABB> _bounds;
+    std::vector<fsv3f> _centroids;
+};
+
+
+#pragma mark - Traversal
+
+/*! @brief Returns the distance at which the ray enters the box, or FLT_MAX if it misses or the entry is beyond \c tMax. */
+inline fsr32
+mn_intersect_aabb(const fsv3f& origin, const fsv3f& inverseDirection, const fsv3f& boundsMin, const fsv3f& boundsMax, fsr32 tMax) {
+    fsr32 tx1 = (boundsMin.x - origin.x) * inverseDirection.x, tx2 = (boundsMax.x - origin.x) * inverseDirection.x;
+    fsr32 tmin = fsMin(tx1, tx2), tmax = fsMax(tx1, tx2);
+    fsr32 ty1 = (boundsMin.y - origin.y) * inverseDirection.y, ty2 = (boundsMax.y - origin.y) * inverseDirection.y;
+    tmin = fsMax(tmin, fsMin(ty1, ty2)), tmax = fsMin(tmax, fsMax(ty1, ty2));
+    fsr32 tz1 = (boundsMin.z - origin.z) * inverseDirection.z, tz2 = (boundsMax.z - origin.z) * inverseDirection.z;
+    tmin = fsMax(tmin, fsMin(tz1, tz2)), tmax = fsMin(tmax, fsMax(tz1, tz2));
+    
+    if (tmax >= tmin && tmin < tMax && tmax > 0.f) {
+        return tmin;
+    }
+    
+    return FLT_MAX;
+}
+
+template <typename LeafFunc>
+void
+mnBVH::traverse(const mnRay& ray, fsr32& hitDistance, LeafFunc&& intersectLeaf) const {
+    if (nodes.empty()) {
+        return;
+    }
+    
+    fsv3f inverseDirection = {1.f / ray.direction.x, 1.f / ray.direction.y, 1.f / ray.direction.z};
+    
+    const mnBVHNode *node = &nodes[0];
+    if (mn_intersect_aabb(ray.origin, inverseDirection, node->boundsMin, node->boundsMax, hitDistance) == FLT_MAX) {
+        return;
+    }
+    
+    const mnBVHNode *stack[64];
+    fsr32 stackDistances[64];
+    fsu32 stackSize = 0;
+    
+    while (node) {
+        if (node->isLeaf()) {
+            if (intersectLeaf(node->leftFirst, node->primitiveCount, hitDistance)) {
+                return;
+            }
+            node = nullptr;
+        } else {
+            const mnBVHNode *child0 = &nodes[node->leftFirst];
+            const mnBVHNode *child1 = &nodes[node->leftFirst + 1];
+            fsr32 dist0 = mn_intersect_aabb(ray.origin, inverseDirection, child0->boundsMin, child0->boundsMax, hitDistance);
+            fsr32 dist1 = mn_intersect_aabb(ray.origin, inverseDirection, child1->boundsMin, child1->boundsMax, hitDistance);
+            if (dist0 > dist1) {
+                fsSwap(dist0, dist1);
+                fsSwap(child0, child1);
+            }
+            
+            node = (dist0 != FLT_MAX ? child0 : nullptr);
+            if (dist1 != FLT_MAX) {
+                fsAssert(stackSize < fsArrayCount(stack));
+                stack[stackSize] = child1;
+                stackDistances[stackSize] = dist1;
+                stackSize++;
+            }
+        }
+        
+        // Pop the next pending node, skipping any that now lie behind the closest hit found so far.
+        while (!node && stackSize > 0) {
+            stackSize--;
+            if (stackDistances[stackSize] < hitDistance) {
+                node = stack[stackSize];
+            }
+        }
+    }
+}
+
+template <typename LeafFunc>
+void
+mnBVH::traversePacket(const mnRayPacket& packet, LeafFunc&& intersectLeaf) const {
+    if (nodes.empty()) {
+        return;
+    }
+    
+    fsr32 maxDistance = packet.getMaxHitDistance();
+    const mnBVHNode *node = &nodes[0];
+    if (mn_intersect_aabb_packet(packet, node->boundsMin, node->boundsMax, maxDistance) == FLT_MAX) {
+        return;
+    }
+    
+    const mnBVHNode *stack[64];
+    fsr32 stackDistances[64];
+    fsu32 stackSize = 0;
+    
+    while (node) {
+        if (node->isLeaf()) {
+            intersectLeaf(node->leftFirst, node->primitiveCount);
+            maxDistance = packet.getMaxHitDistance();
+            node = nullptr;
+        } else {
+            const mnBVHNode *child0 = &nodes[node->leftFirst];
+            const mnBVHNode *child1 = &nodes[node->leftFirst + 1];
+            fsr32 dist0 = mn_intersect_aabb_packet(packet, child0->boundsMin, child0->boundsMax, maxDistance);
+            fsr32 dist1 = mn_intersect_aabb_packet(packet, child1->boundsMin, child1->boundsMax, maxDistance);
+            if (dist0 > dist1) {
+                fsSwap(dist0, dist1);
+                fsSwap(child0, child1);
+            }
+            
+            node = (dist0 != FLT_MAX ? child0 : nullptr);
+            if (dist1 != FLT_MAX) {
+                fsAssert(stackSize < fsArrayCount(stack));
+                stack[stackSize] = child1;
+                stackDistances[stackSize] = dist1;
+                stackSize++;
+            }
+        }
+        
+        while (!node && stackSize > 0) {
+            stackSize--;
+            if (stackDistances[stackSize] < maxDistance) {
+                node = stack[stackSize];
+            }
+        }
+    }
+}
@@ -8,6 +8,7 @@
 
 #include "minuet_camera.h"
 #include "fs_input.h"
+#include "fs_simd.h"
 
 
 mnCamera::mnCamera(fsr32 verticalFOV, fsr32 nearClip, fsr32 farClip)
@@ -98,6 +99,35 @@ mnCamera::resize(fsi16 width, fsi16 height) {
     recalculateRayDirections();
 }
 
+void
+mnCamera::setView(const fsv3f& position, const fsv3f& forwardDirection) {
+    _position = position;
+    _forwardDirection = fs_vnormalize(forwardDirection);
+    
+    recalculateView();
+    recalculateRayDirections();
+}
+
+void
+mnCamera::copyView(const mnCamera& camera) {
+    _projection = camera._projection;
+    _view = camera._view;
+    _inverseProjection = camera._inverseProjection;
+    _inverseView = camera._inverseView;
+    _verticalFOV = camera._verticalFOV;
+    _nearClip = camera._nearClip;
+    _farClip = camera._farClip;
+    _position = camera._position;
+    _forwardDirection = camera._forwardDirection;
+    _rayCorner = camera._rayCorner;
+    _rayDeltaX = camera._rayDeltaX;
+    _rayDeltaY = camera._rayDeltaY;
+    _lastMousePosition = camera._lastMousePosition;
+    _viewportWidth = camera._viewportWidth;
+    _viewportHeight = camera._viewportHeight;
+    _rayDirectionsDirty = true;
+}
+
 fsr32
 mnCamera::getRotationSpeed() {
     return 0.3f;
@@ -118,10 +148,69 @@ mnCamera::recalculateView() {
 
 void
 mnCamera::recalculateRayDirections() {
+    // NOTE(christian): Unprojecting the far plane is affine in the pixel coordinates, and so is rotating by the inverse view,
+    // so every unnormalized direction is the corner direction plus a multiple of each per-pixel delta.
+    auto unproject = [this](fsr32 x, fsr32 y) {
+        fsv2f coord = { x / _viewportWidth, y / _viewportHeight };
+        coord = coord * 2.f - (fsv2f){1.f, 1.f}; // -1 -> 1
+        
+        fsv4f target = _inverseProjection * (fsv4f){coord.x, coord.y, 1.f, 1.f};
+        fsv3f t = target.xyz / target.w;
+        fsv4f rayDirection = _inverseView * (fsv4f){t.x, t.y, t.z, 0.f};
+        return rayDirection.xyz;
+    };
+    
+    _rayCorner = unproject(0.f, 0.f);
+    _rayDeltaX = (unproject((fsr32)_viewportWidth, 0.f) - _rayCorner) * (1.f / fsMax(_viewportWidth, (fsi16)1));
+    _rayDeltaY = (unproject(0.f, (fsr32)_viewportHeight) - _rayCorner) * (1.f / fsMax(_viewportHeight, (fsi16)1));
+    _rayDirectionsDirty = true;
+}
+
+void
+mnCamera::generateRayDirections(fsu32 x, fsu32 y, fsu32 count, fsr32 *directionX, fsr32 *directionY, fsr32 *directionZ) const {
+    static const fsr32 kLaneOffsets[] = {0.f, 1.f, 2.f, 3.f, 4.f, 5.f, 6.f, 7.f};
+    static_assert(fsArrayCount(kLaneOffsets) >= FS_SIMD_WIDTH, "Need an offset for every lane.");
+    
+    fsv3f rowStart = _rayCorner + _rayDeltaY * (fsr32)y;
+    fsWide startX = fs_wide_set1(rowStart.x), startY = fs_wide_set1(rowStart.y), startZ = fs_wide_set1(rowStart.z);
+    fsWide deltaX = fs_wide_set1(_rayDeltaX.x), deltaY = fs_wide_set1(_rayDeltaX.y), deltaZ = fs_wide_set1(_rayDeltaX.z);
+    fsWide laneOffsets = fs_wide_load(kLaneOffsets);
+    fsWide one = fs_wide_set1(1.f);
+    
+    for (fsu32 i = 0; i < count; i += FS_SIMD_WIDTH) {
+        fsWide px = fs_wide_set1((fsr32)(x + i)) + laneOffsets;
+        fsWide dx = startX + deltaX * px;
+        fsWide dy = startY + deltaY * px;
+        fsWide dz = startZ + deltaZ * px;
+        fsWide inverseLength = one / fs_wide_sqrt(dx * dx + dy * dy + dz * dz);
+        fs_wide_store(directionX + i, dx * inverseLength);
+        fs_wide_store(directionY + i, dy * inverseLength);
+        fs_wide_store(directionZ + i, dz * inverseLength);
+    }
+}
+
+void
+mnCamera::getInverseRayBasis(fsv3f rows[3]) const {
+    // NOTE(christian): Offsets along pixel (x, y)'s ray are s * [corner | deltaX | deltaY] * (1, x, y), so inverting that
+    // 3x3 matrix (by its cofactors) recovers the pixel from any point in front of the camera.
+    fsv3f a = _rayCorner, b = _rayDeltaX, c = _rayDeltaY;
+    fsv3f bc = fs_vcross(b, c);
+    fsr32 inverseDeterminant = 1.f / fs_vdot(a, bc);
+    rows[0] = bc * inverseDeterminant;
+    rows[1] = fs_vcross(c, a) * inverseDeterminant;
+    rows[2] = fs_vcross(a, b) * inverseDeterminant;
+}
+
+const std::vector<fsv3f>&
+mnCamera::getRayDirections() const {
+    if (!_rayDirectionsDirty) {
+        return _rayDirections;
+    }
+    
     _rayDirections.resize(_viewportWidth * _viewportHeight);
     
-    for (fsu32 y = 0; y < _viewportHeight; ++y) {
-        for (fsu32 x = 0; x < _viewportWidth; ++x) {
+    for (fsi32 y = 0; y < _viewportHeight; ++y) {
+        for (fsi32 x = 0; x < _viewportWidth; ++x) {
             fsv2f coord = { (fsr32)x / _viewportWidth, (fsr32)y / _viewportHeight };
             coord = coord * 2.f - (fsv2f){1.f, 1.f}; // -1 -> 1
             
@@ -131,4 +220,7 @@ mnCamera::recalculateRayDirections() {
             _rayDirections[x + y * _viewportWidth] = rayDirection.xyz;
         }
     }
+    
+    _rayDirectionsDirty = false;
+    return _rayDirections;
 }
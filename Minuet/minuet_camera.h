@@ -19,16 +19,36 @@ struct mnCamera {
     
     bool update(fsRawInput *input, mnPlatform *platform, fsr32 dt);
     void resize(fsi16 width, fsi16 height);
+    /*! @brief Places the camera at \c position looking along \c forwardDirection, for callers that drive the camera without input. */
+    void setView(const fsv3f& position, const fsv3f& forwardDirection);
+    /*! @brief Copies everything about \c camera except its ray direction table, which is left to be rebuilt here on first use.
+        Cheap enough to do every frame, unlike assignment. */
+    void copyView(const mnCamera& camera);
     
     const fsmat4f& getProjection() const { return _projection; }
     const fsmat4f& getInverseProjection() const { return _inverseProjection; }
     const fsmat4f& getView() const { return _view; }
     const fsmat4f& getInverseView() const { return _inverseView; }
     
+    fsi16 getViewportWidth() const { return _viewportWidth; }
+    fsi16 getViewportHeight() const { return _viewportHeight; }
+    
     const fsv3f& getPosition() const { return _position; }
     const fsv3f& getDirection() const { return _forwardDirection; }
     
-    const std::vector<fsv3f>& getRayDirections() const { return _rayDirections; }
+    /*! @brief Unit direction of the primary ray through pixel (x, y), interpolated from the corner ray. */
+    fsv3f getRayDirection(fsu32 x, fsu32 y) const {
+        return fs_vnormalize(_rayCorner + _rayDeltaX * (fsr32)x + _rayDeltaY * (fsr32)y);
+    }
+    /*! @brief Writes the directions of \c count consecutive pixels starting at (x, y) as SoA components, several at a time.
+        Each array needs room for \c count rounded up to a multiple of FS_SIMD_WIDTH. */
+    void generateRayDirections(fsu32 x, fsu32 y, fsu32 count, fsr32 *directionX, fsr32 *directionY, fsr32 *directionZ) const;
+    /*! @brief Per-pixel table of ray directions, rebuilt on first use after the camera changes. Kept for comparison with
+        generating them on the fly; it costs 12 bytes per pixel and a full-screen pass on every change. */
+    const std::vector<fsv3f>& getRayDirections() const;
+    /*! @brief Inverse of the ray generator: rows of the matrix that maps an offset from the camera position to (s, s * x, s * y),
+        where pixel (x, y) is the one whose ray passes through it, s > 0 in front of the camera. */
+    void getInverseRayBasis(fsv3f rows[3]) const;
     
     fsr32 getRotationSpeed();
     
@@ -50,7 +70,13 @@ private:
     fsv3f _position = {0.f, 0.f, 0.f};
     fsv3f _forwardDirection = {0.f, 0.f, 0.f};
     
-    std::vector<fsv3f> _rayDirections;
+    // Unnormalized world-space direction through pixel (0, 0), and its change per pixel along x and y.
+    fsv3f _rayCorner = {0.f, 0.f, -1.f};
+    fsv3f _rayDeltaX = {0.f, 0.f, 0.f};
+    fsv3f _rayDeltaY = {0.f, 0.f, 0.f};
+    
+    mutable std::vector<fsv3f> _rayDirections;
+    mutable bool _rayDirectionsDirty = true;
     
     fsv2f _lastMousePosition = {0.f, 0.f};
     
@@ -6,6 +6,7 @@
 //
 
 #include "minuet_platform.h"
+#include <limits>
 
 fsu32
 pcgHash(fsu32 input) {
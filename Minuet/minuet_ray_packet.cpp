@@ -0,0 +1,68 @@
+//
+//  minuet_ray_packet.cpp
+//  Minuet
+//
+//  Created by Christian Floisand on 2026-10-16.
+//
+
+#include "minuet_ray_packet.h"
+#include "fs_simd.h"
+
+
+#pragma mark - mnRayPacket
+
+fsu32
+mnRayPacket::addRay(const mnRay& ray, fsr32 maxDistance) {
+    fsAssert(count < kMaxRayCount);
+    fsu32 index = count++;
+    originX[index] = ray.origin.x;
+    originY[index] = ray.origin.y;
+    originZ[index] = ray.origin.z;
+    directionX[index] = ray.direction.x;
+    directionY[index] = ray.direction.y;
+    directionZ[index] = ray.direction.z;
+    hitDistance[index] = maxDistance;
+    hitObject[index] = -1;
+    return index;
+}
+
+void
+mnRayPacket::finalize() {
+    fsAssert(count > 0);
+    
+    // NOTE(christian): Padding rays have a zero hit distance, so the kernel's (t > 0 && t < hitDistance) test never lets them
+    // hit anything, and they don't take part in the interval bounds below.
+    paddedCount = fs_next_multiple(count, (fsu32)FS_SIMD_WIDTH);
+    for (fsu32 i = count; i < paddedCount; ++i) {
+        originX[i] = originX[0], originY[i] = originY[0], originZ[i] = originZ[0];
+        directionX[i] = directionX[0], directionY[i] = directionY[0], directionZ[i] = directionZ[0];
+        hitDistance[i] = 0.f;
+        hitObject[i] = -1;
+    }
+    
+    fsv3f directionMin, directionMax;
+    originMin = originMax = {originX[0], originY[0], originZ[0]};
+    directionMin = directionMax = {directionX[0], directionY[0], directionZ[0]};
+    for (fsu32 i = 1; i < count; ++i) {
+        originMin = {fsMin(originMin.x, originX[i]), fsMin(originMin.y, originY[i]), fsMin(originMin.z, originZ[i])};
+        originMax = {fsMax(originMax.x, originX[i]), fsMax(originMax.y, originY[i]), fsMax(originMax.z, originZ[i])};
+        directionMin = {fsMin(directionMin.x, directionX[i]), fsMin(directionMin.y, directionY[i]), fsMin(directionMin.z, directionZ[i])};
+        directionMax = {fsMax(directionMax.x, directionX[i]), fsMax(directionMax.y, directionY[i]), fsMax(directionMax.z, directionZ[i])};
+    }
+    
+    // The reciprocal is monotonic on either side of zero, so the interval's ends swap.
+    for (fsi32 axis = 0; axis < 3; ++axis) {
+        directionsAgree[axis] = (directionMin.e[axis] > 0.f || directionMax.e[axis] < 0.f);
+        inverseDirectionMin.e[axis] = (directionsAgree[axis] ? 1.f / directionMax.e[axis] : 0.f);
+        inverseDirectionMax.e[axis] = (directionsAgree[axis] ? 1.f / directionMin.e[axis] : 0.f);
+    }
+}
+
+fsr32
+mnRayPacket::getMaxHitDistance() const {
+    fsr32 maxDistance = hitDistance[0];
+    for (fsu32 i = 1; i < count; ++i) {
+        maxDistance = fsMax(maxDistance, hitDistance[i]);
+    }
+    return maxDistance;
+}
@@ -0,0 +1,85 @@
+//
+//  minuet_ray_packet.h
+//  Minuet
+//
+//  Created by Christian Floisand on 2026-10-16.
+//
+
+#pragma once
+#include "minuet_platform.h"
+#include "minuet_ray.h"
+
+
+#pragma mark - mnRayPacket
+
+/*! @brief Up to 64 coherent rays (an 8x8 block of primary rays) in structure-of-arrays form, traced together so that BVH nodes
+    and primitives are culled once for the whole packet and the intersection kernels run across rays instead of across
+    primitives. Call \c finalize after adding rays and before tracing; it computes the interval bounds used for culling. */
+struct mnRayPacket {
+    static const fsu32 kMaxRayCount = 64;
+    
+    void clear() { count = 0; }
+    /*! @brief Adds a ray that can hit anything closer than \c maxDistance. Returns its index in the packet. */
+    fsu32 addRay(const mnRay& ray, fsr32 maxDistance);
+    void finalize();
+    
+    mnRay getRay(fsu32 index) const {
+        mnRay ray;
+        ray.origin = {originX[index], originY[index], originZ[index]};
+        ray.direction = {directionX[index], directionY[index], directionZ[index]};
+        return ray;
+    }
+    
+    /*! @brief Largest hit distance of any ray in the packet; anything farther away can't affect the packet. */
+    fsr32 getMaxHitDistance() const;
+
+public:
+    fsr32 originX[kMaxRayCount];
+    fsr32 originY[kMaxRayCount];
+    fsr32 originZ[kMaxRayCount];
+    fsr32 directionX[kMaxRayCount];
+    fsr32 directionY[kMaxRayCount];
+    fsr32 directionZ[kMaxRayCount];
+    fsr32 hitDistance[kMaxRayCount];
+    fsi32 hitObject[kMaxRayCount];  // Object index of the closest hit, as stored in mnSphereSoA or mnTriangleSoA, or -1
+    fsu32 count = 0;
+    fsu32 paddedCount = 0;          // count rounded up to a whole number of SIMD widths by finalize
+    
+    // Interval bounds over every ray in the packet, per axis.
+    fsv3f originMin, originMax;
+    fsv3f inverseDirectionMin, inverseDirectionMax;
+    bool directionsAgree[3];        // False if the packet's directions have mixed signs along the axis
+};
+
+
+#pragma mark - Culling
+
+/*! @brief Interval arithmetic version of the slab test: returns a lower bound on the distance at which any ray in \c packet
+    enters the box, or FLT_MAX if no ray can hit it before \c tMax. Conservative, so it may keep a box no ray actually hits. */
+inline fsr32
+mn_intersect_aabb_packet(const mnRayPacket& packet, const fsv3f& boundsMin, const fsv3f& boundsMax, fsr32 tMax) {
+    fsr32 tEnter = 0.f;
+    fsr32 tExit = tMax;
+    for (fsi32 axis = 0; axis < 3; ++axis) {
+        if (!packet.directionsAgree[axis]) {
+            continue;
+        }
+        
+        // NOTE(christian): With every direction on the same side of zero, the near and far planes are the same for the whole
+        // packet, and each slab distance is (plane - origin) * inverseDirection over the intervals of both factors.
+        fsr32 inverseMin = packet.inverseDirectionMin.e[axis];
+        fsr32 inverseMax = packet.inverseDirectionMax.e[axis];
+        bool positive = (inverseMin > 0.f);
+        fsr32 nearPlane = (positive ? boundsMin.e[axis] : boundsMax.e[axis]);
+        fsr32 farPlane = (positive ? boundsMax.e[axis] : boundsMin.e[axis]);
+        
+        fsr32 nearLo = nearPlane - packet.originMax.e[axis], nearHi = nearPlane - packet.originMin.e[axis];
+        fsr32 farLo = farPlane - packet.originMax.e[axis], farHi = farPlane - packet.originMin.e[axis];
+        fsr32 enter = fsMin(fsMin(nearLo * inverseMin, nearLo * inverseMax), fsMin(nearHi * inverseMin, nearHi * inverseMax));
+        fsr32 exit = fsMax(fsMax(farLo * inverseMin, farLo * inverseMax), fsMax(farHi * inverseMin, farHi * inverseMax));
+        tEnter = fsMax(tEnter, enter);
+        tExit = fsMin(tExit, exit);
+    }
+    
+    return (tEnter <= tExit ? tEnter : FLT_MAX);
+}
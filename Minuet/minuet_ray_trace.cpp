@@ -8,7 +8,9 @@
 #include "minuet_ray_trace.h"
 #include "minuet_camera.h"
 #include "minuet_renderer.h"
+#include "minuet_render_thread.h"
 #include "minuet_platform.h"
+#include "minuet_scene_file.h"
 
 
 #pragma mark - mnPlatform
@@ -123,6 +125,59 @@ mn_make_scene() {
     return scene;
 }
 
+mnScene*
+mn_make_random_scene(fsu32 sphereCount, fsu32 seed) {
+    mnScene *scene = new mnScene;
+    
+    const fsu32 kMaterialCount = 16;
+    for (fsu32 i = 0; i < kMaterialCount; ++i) {
+        mnMaterial material;
+        material.albedo = fsv3f_random(seed) * 0.5f + (fsv3f){0.5f, 0.5f, 0.5f};
+        material.roughness = randomFloat(seed);
+        if (i == 0) {
+            material.emissionColor = material.albedo;
+            material.emissionPower = 4.f;
+        }
+        scene->materials.push_back(material);
+    }
+    
+    // NOTE(christian): Grow the volume with the sphere count so density (and so the expected depth complexity) stays constant.
+    fsr32 extent = fsMax(8.f, 1.5f * cbrtf((fsr32)sphereCount));
+    scene->spheres.reserve(sphereCount);
+    for (fsu32 i = 0; i < sphereCount; ++i) {
+        mnSphere sphere;
+        sphere.position.x = (randomFloat(seed) * 2.f - 1.f) * extent;
+        sphere.position.y = (randomFloat(seed) * 2.f - 1.f) * extent;
+        sphere.position.z = -randomFloat(seed) * 2.f * extent;
+        sphere.radius = 0.2f + randomFloat(seed) * 0.4f;
+        sphere.materialIndex = (fsi32)(pcgHash(i) % kMaterialCount);
+        scene->spheres.push_back(sphere);
+    }
+    
+    return scene;
+}
+
+mnScene*
+mn_load_scene(const char *path) {
+    return mn_load_scene_file(path);
+}
+
+int32_t
+mn_scene_add_obj(mnScene *scene, const char *path, int32_t materialIndex) {
+    if (materialIndex < 0 || (size_t)materialIndex >= scene->materials.size()) {
+        return 0;
+    }
+    
+    mnMesh mesh;
+    mesh.materialIndex = materialIndex;
+    if (!mn_load_obj(path, mesh)) {
+        return 0;
+    }
+    scene->meshes.push_back(std::move(mesh));
+    scene->revision++;
+    return 1;
+}
+
 
 #pragma mark - mnRenderer
 mnRenderer*
@@ -136,11 +191,57 @@ mn_renderer_render(mnRenderer *renderer, mnScene *scene, mnCamera *camera) {
     return renderer->render(*scene, *camera);
 }
 
+void
+mn_renderer_render_into(mnRenderer *renderer, mnScene *scene, mnCamera *camera, void *dst, size_t stride, mnOutputFormat format) {
+    mnPixelFormat pixelFormat = (format == mnOutputFormatBGRA8 ? mnPixelFormat::bgra8 : mnPixelFormat::rgba8);
+    renderer->renderInto(*scene, *camera, dst, stride, pixelFormat);
+}
+
 void
 mn_renderer_resize(mnRenderer *renderer, fsi16 width, fsi16 height) {
     renderer->resize(width, height);
 }
 
+void
+mn_renderer_get_stats(mnRenderer *renderer, mnRenderStats *stats) {
+    *stats = renderer->getStats();
+}
+
+fsi32
+mn_stats_enabled() {
+    return MN_STATS;
+}
+
+
+#pragma mark - mnRenderThread
+
+mnRenderThread*
+mn_make_render_thread(mnRenderer *renderer) {
+    mnRenderThread *thread = new mnRenderThread(*renderer);
+    return thread;
+}
+
+void
+mn_render_thread_start(mnRenderThread *thread) {
+    thread->start();
+}
+
+void
+mn_render_thread_stop(mnRenderThread *thread) {
+    thread->stop();
+}
+
+void
+mn_render_thread_submit(mnRenderThread *thread, mnScene *scene, mnCamera *camera, fsi32 cameraChanged) {
+    thread->submit(*scene, *camera, cameraChanged != 0);
+}
+
+mnImage*
+mn_render_thread_acquire_image(mnRenderThread *thread) {
+    const mnRenderThread::Frame *frame = thread->acquireFrame();
+    return (frame ? const_cast<mnImage *>(&frame->image) : nullptr);
+}
+
 
 #pragma mark - mnCamera
 
@@ -158,6 +259,11 @@ mn_camera_resize(mnCamera *camera, fsi16 width, fsi16 height) {
 void
 mn_camera_update(mnCamera *camera, mnRenderer *renderer, fsRawInput *input, fsr32 dt) {
     if (camera->update(input, &platform, dt)) {
-        renderer->resetFrameIndex();
+        renderer->cameraChanged();
     }
 }
+
+fsi32
+mn_camera_handle_input(mnCamera *camera, fsRawInput *input, fsr32 dt) {
+    return camera->update(input, &platform, dt);
+}
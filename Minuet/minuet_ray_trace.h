@@ -6,7 +6,9 @@
 //
 
 #pragma once
+#include <stddef.h>
 #include <stdint.h>
+#include "minuet_stats.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -50,6 +52,18 @@ typedef struct mnScene mnScene;
 
 mnScene* mn_make_scene();
 
+/*! @brief Makes a scene of \c sphereCount randomly placed spheres in front of the default camera, with a mix of diffuse and
+    emissive materials. The same \c seed always produces the same scene. */
+mnScene* mn_make_random_scene(uint32_t sphereCount, uint32_t seed);
+
+/*! @brief Loads a scene from a binary or text scene file (see minuet_scene_file.h). Binary files are mapped rather than read,
+    so nothing is copied as they load. Returns null on failure. */
+mnScene* mn_load_scene(const char *path);
+
+/*! @brief Loads the triangles of an OBJ file as a new mesh of \c scene, shaded with the material at \c materialIndex.
+    Returns non-zero on success. */
+int32_t mn_scene_add_obj(mnScene *scene, const char *path, int32_t materialIndex);
+
 #pragma mark - mnRenderer
 struct mnRenderer;
 typedef struct mnRenderer mnRenderer;
@@ -59,8 +73,46 @@ mnRenderer* mn_make_renderer();
 
 mnImage* mn_renderer_render(mnRenderer *renderer, mnScene *scene, mnCamera *camera);
 
+/*! @brief Byte order of each pixel written by \c mn_renderer_render_into. */
+typedef enum mnOutputFormat {
+    mnOutputFormatRGBA8 = 0,
+    mnOutputFormatBGRA8 = 1,
+} mnOutputFormat;
+
+/*! @brief Renders a frame and writes its pixels straight into \c dst, which holds the renderer's height in rows of its width
+    in 4-byte pixels, \c stride bytes apart. Nothing is copied through the renderer's own image. Passing the same buffer every
+    frame, or rotating between up to three, lets the renderer rewrite only the parts that changed since a buffer was last
+    passed, so they must not be modified in between. */
+void mn_renderer_render_into(mnRenderer *renderer, mnScene *scene, mnCamera *camera, void *dst, size_t stride, mnOutputFormat format);
+
 void mn_renderer_resize(mnRenderer *renderer, int16_t width, int16_t height);
 
+/*! @brief Copies the counters gathered during the last render into \c stats. */
+void mn_renderer_get_stats(mnRenderer *renderer, mnRenderStats *stats);
+
+/*! @brief Returns non-zero if the library was built with detailed statistics (MN_STATS); otherwise only the ray count is gathered. */
+int32_t mn_stats_enabled(void);
+
+#pragma mark - mnRenderThread
+struct mnRenderThread;
+typedef struct mnRenderThread mnRenderThread;
+
+/*! @brief Makes a thread that renders with \c renderer. Nothing else may use the renderer while the thread is running. */
+mnRenderThread* mn_make_render_thread(mnRenderer *renderer);
+
+void mn_render_thread_start(mnRenderThread *thread);
+
+void mn_render_thread_stop(mnRenderThread *thread);
+
+/*! @brief Hands the render thread the scene and camera to render from its next frame on. The scene is only copied when
+    its revision changed since the last submit. Pass non-zero \c cameraChanged if the camera moved since the last submit.
+    Never waits for the render thread. */
+void mn_render_thread_submit(mnRenderThread *thread, mnScene *scene, mnCamera *camera, int32_t cameraChanged);
+
+/*! @brief Returns the newest finished image, or null before the first frame. It stays valid until the next call, and never
+    waits for the render thread. */
+mnImage* mn_render_thread_acquire_image(mnRenderThread *thread);
+
 #pragma mark - mnCamera
 struct mnCamera;
 typedef struct mnCamera mnCamera;
@@ -73,6 +125,10 @@ void mn_camera_resize(mnCamera *camera, int16_t width, int16_t height);
 
 void mn_camera_update(mnCamera *camera, mnRenderer *renderer, fsRawInput *input, float dt);
 
+/*! @brief Moves the camera from \c input, like \c mn_camera_update, but returns non-zero if it moved instead of telling a
+    renderer. */
+int32_t mn_camera_handle_input(mnCamera *camera, fsRawInput *input, float dt);
+
 #ifdef __cplusplus
 }
 #endif
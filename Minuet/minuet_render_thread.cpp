@@ -0,0 +1,123 @@
+//
+//  minuet_render_thread.cpp
+//  Minuet
+//
+//  Created by Christian Floisand on 2026-10-16.
+//
+
+#include "minuet_render_thread.h"
+#include <chrono>
+
+
+#pragma mark - mnRenderThread
+
+mnRenderThread::mnRenderThread(mnRenderer& renderer)
+    : _renderer(renderer)
+{
+    _settings = renderer.getSettings();
+}
+
+mnRenderThread::~mnRenderThread() {
+    stop();
+}
+
+void
+mnRenderThread::start() {
+    if (_running.exchange(true)) {
+        return;
+    }
+    _thread = std::thread([this]() { run(); });
+}
+
+void
+mnRenderThread::stop() {
+    if (!_running.exchange(false)) {
+        return;
+    }
+    _thread.join();
+}
+
+void
+mnRenderThread::submit(const mnScene& scene, const mnCamera& camera, bool cameraChanged) {
+    if (cameraChanged) {
+        ++_cameraRevision;
+    }
+    
+    // NOTE(christian): Snapshots share one immutable copy of the scene until it's edited, so an unchanged scene costs a
+    // reference count per submit rather than a copy of every sphere and mesh.
+    if (!_submittedScene || &scene != _submittedSceneAddress || scene.revision != _submittedSceneRevision) {
+        _submittedScene = std::make_shared<const mnScene>(scene);
+        _submittedSceneAddress = &scene;
+        _submittedSceneRevision = scene.revision;
+    }
+    
+    Snapshot& snapshot = _snapshots.getBack();
+    snapshot.scene = _submittedScene;
+    snapshot.camera.copyView(camera);
+    snapshot.settings = _settings;
+    snapshot.cameraRevision = _cameraRevision;
+    snapshot.resetRevision = _resetRevision;
+    _snapshots.publish();
+}
+
+const mnRenderThread::Frame*
+mnRenderThread::acquireFrame() {
+    _frameAcquired |= _frames.acquire();
+    return (_frameAcquired ? &_frames.getFront() : nullptr);
+}
+
+void
+mnRenderThread::run() {
+    while (_running.load(std::memory_order_relaxed)) {
+        if (_snapshots.acquire()) {
+            const Snapshot& snapshot = _snapshots.getFront();
+            _renderer.getSettings() = snapshot.settings;
+            if (snapshot.scene != _sourceScene) {
+                _scene = *snapshot.scene;
+                _sourceScene = snapshot.scene;
+            }
+            bool resized = (snapshot.camera.getViewportWidth() != _camera.getViewportWidth() ||
+                            snapshot.camera.getViewportHeight() != _camera.getViewportHeight());
+            bool cameraMoved = (snapshot.cameraRevision != _renderedCameraRevision);
+            
+            // NOTE(christian): Frames in between snapshots would otherwise go back to full resolution while the camera is
+            // still moving. It's only known to have stopped once a snapshot arrives without a new camera.
+            _renderer.setCameraMoving(_hasSnapshot && cameraMoved);
+            if (!_hasSnapshot || resized || cameraMoved) {
+                _camera.copyView(snapshot.camera);
+                _renderedCameraRevision = snapshot.cameraRevision;
+                _renderer.resize(_camera.getViewportWidth(), _camera.getViewportHeight());
+                _renderer.cameraChanged();
+            }
+            if (snapshot.resetRevision != _renderedResetRevision) {
+                _renderedResetRevision = snapshot.resetRevision;
+                _renderer.resetFrameIndex();
+            }
+            _hasSnapshot = true;
+        }
+        
+        // NOTE(christian): With nothing to render yet, or nothing left to add because every pixel has converged, there's no
+        // point spinning a core until the next snapshot arrives.
+        const mnRenderer::Settings& settings = _renderer.getSettings();
+        fsu32 pixelCount = _camera.getViewportWidth() * _camera.getViewportHeight();
+        bool converged = (settings.adaptiveSampling && settings.accumulate && _renderer.getConvergedPixelCount() == pixelCount);
+        if (!_hasSnapshot || pixelCount == 0 || converged) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+        
+        // NOTE(christian): The frame is resolved straight into the back slot. The renderer remembers all three slots, so each
+        // one only gets the tiles that changed since it last held a frame; at most three frames' worth of samples, and none
+        // once the image has converged, rather than a full resolve or a copy of the whole frame.
+        Frame& frame = _frames.getBack();
+        fsi16 width = _camera.getViewportWidth(), height = _camera.getViewportHeight();
+        frame.image.resize(width, height);
+        _renderer.renderInto(_scene, _camera, frame.image.pixelData, width * sizeof(fsu32), mnPixelFormat::rgba32);
+        frame.stats = _renderer.getStats();
+        frame.renderTime = _renderer.lastRenderTime;
+        frame.passCount = _renderer.getFramePassCount();
+        frame.convergedPixelCount = _renderer.getConvergedPixelCount();
+        frame.resolutionScale = _renderer.getResolutionScale();
+        _frames.publish();
+    }
+}
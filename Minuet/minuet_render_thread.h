@@ -0,0 +1,129 @@
+//
+//  minuet_render_thread.h
+//  Minuet
+//
+//  Created by Christian Floisand on 2026-10-16.
+//
+
+#pragma once
+#include "minuet_platform.h"
+#include "minuet_camera.h"
+#include "minuet_renderer.h"
+#include "minuet_scene.h"
+#include <atomic>
+#include <memory>
+#include <thread>
+
+
+#pragma mark - mnTripleBuffer
+
+/*! @brief Three slots shared by one producer and one consumer thread, neither of which ever waits for the other. The producer
+    fills its back slot and publishes it by swapping it with the middle one; the consumer takes the middle slot in exchange
+    for its front one, but only if something was published since it last did. Each side owns its slot until it swaps it. */
+template<typename T>
+struct mnTripleBuffer {
+    T& getBack() { return _slots[_back]; }
+    /*! @brief Makes the back slot the latest one, and hands the producer the slot that was waiting in the middle. */
+    void publish() {
+        _back = _middle.exchange(_back | kFreshBit, std::memory_order_acq_rel) & kIndexMask;
+    }
+    
+    T& getFront() { return _slots[_front]; }
+    /*! @brief Moves the latest published slot to the front. Returns false, keeping the current front, if nothing new was
+        published since the last call. */
+    bool acquire() {
+        if (!(_middle.load(std::memory_order_relaxed) & kFreshBit)) {
+            return false;
+        }
+        _front = _middle.exchange(_front, std::memory_order_acq_rel) & kIndexMask;
+        return true;
+    }
+
+private:
+    static const fsu32 kIndexMask = 0x3;
+    static const fsu32 kFreshBit = 0x4;
+    
+    T _slots[3];
+    fsu32 _back = 0;
+    fsu32 _front = 1;
+    std::atomic<fsu32> _middle{2};
+};
+
+
+#pragma mark - mnRenderThread
+
+/*! @brief Runs a renderer on its own thread, so that neither the UI nor the renderer waits on the other. The UI submits the
+    scene, camera and settings as a snapshot whenever it likes, and picks up the newest finished frame whenever it likes;
+    the render thread starts each frame from the newest snapshot and otherwise keeps accumulating. */
+struct mnRenderThread {
+    /*! @brief A finished frame: the image and what the renderer reported about it. */
+    struct Frame {
+        mnImage image{0, 0};
+        mnRenderStats stats = {};
+        fsr64 renderTime = 0.0;
+        fsu32 passCount = 0;
+        fsu32 convergedPixelCount = 0;
+        fsr32 resolutionScale = 1.f;
+    };
+    
+    explicit mnRenderThread(mnRenderer& renderer);
+    ~mnRenderThread();
+    
+    mnRenderThread(const mnRenderThread&) = delete;
+    mnRenderThread& operator=(const mnRenderThread&) = delete;
+    
+    void start();
+    /*! @brief Waits for the frame in progress to finish, then stops the thread. */
+    void stop();
+    
+    /*! @brief The settings the next submitted snapshot carries. Only the submitting thread may touch them. */
+    mnRenderer::Settings& getSettings() { return _settings; }
+    /*! @brief Has the renderer start accumulating from scratch once it picks up the next snapshot. */
+    void resetAccumulation() { ++_resetRevision; }
+    /*! @brief Publishes \c scene, \c camera and the settings. The scene is only copied when it's a different scene or its
+        revision changed since the last submit, and the camera is copied without its ray direction table, so submitting every
+        frame is cheap. \c cameraChanged says the camera moved since the last submit; the render thread only takes a new
+        camera then or when it's resized. */
+    void submit(const mnScene& scene, const mnCamera& camera, bool cameraChanged);
+    
+    /*! @brief Returns the newest finished frame, or null before the first one. It stays valid, and unchanged, until the next call. */
+    const Frame* acquireFrame();
+    /*! @brief The frame the last \c acquireFrame returned. */
+    const Frame* getFrame() { return (_frameAcquired ? &_frames.getFront() : nullptr); }
+
+private:
+    struct Snapshot {
+        std::shared_ptr<const mnScene> scene;   // Shared between snapshots until the submitted scene changes
+        mnCamera camera{45.f, 0.1f, 100.f};
+        mnRenderer::Settings settings;
+        fsu32 cameraRevision = 0;
+        fsu32 resetRevision = 0;
+    };
+    
+    void run();
+
+private:
+    mnRenderer& _renderer;
+    std::thread _thread;
+    std::atomic<bool> _running{false};
+    
+    // Submitting side.
+    mnRenderer::Settings _settings;
+    fsu32 _cameraRevision = 0;
+    fsu32 _resetRevision = 0;
+    bool _frameAcquired = false;
+    std::shared_ptr<const mnScene> _submittedScene;
+    const mnScene * _submittedSceneAddress = nullptr;
+    fsu32 _submittedSceneRevision = 0;
+    
+    // Render side. The scene and camera are kept in one place, since the renderer keys its caches on their addresses.
+    mnScene _scene;
+    std::shared_ptr<const mnScene> _sourceScene;    // The snapshot's scene that _scene was copied from
+    mnCamera _camera{45.f, 0.1f, 100.f};
+    fsu32 _renderedCameraRevision = 0;
+    fsu32 _renderedResetRevision = 0;
+    bool _hasSnapshot = false;
+    
+    mnTripleBuffer<Snapshot> _snapshots;
+    mnTripleBuffer<Frame> _frames;
+};
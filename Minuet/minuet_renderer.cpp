@@ -7,7 +7,8 @@
 //
 
 #include "minuet_renderer.h"
-#include <dispatch/dispatch.h>
+#include "fs_simd.h"
+#include <algorithm>
 
 
 #pragma mark - mnImage
@@ -36,66 +37,931 @@ mnImage::resize(fsi16 w, fsi16 h) {
 
 #pragma mark - mnRenderer
 
-static fsu32
-convertToRGBA(const fsv4f& color) {
-    fsu8 r = (fsu8)(color.r * 255.f);
-    fsu8 g = (fsu8)(color.g * 255.f);
-    fsu8 b = (fsu8)(color.b * 255.f);
-    fsu8 a = (fsu8)(color.a * 255.f);
-    
-    fsu32 result = (r << 24) | (g << 16) | (b << 8) | a;
-    return result;
+// Most samples the rgba16f running mean weights its history as; see accumulatePixel.
+static const fsr32 kHalfAccumulationMaxWeight = 1024.f;
+
+static fsr32
+luminance(const fsv4f& color) {
+    return 0.2126f * color.r + 0.7152f * color.g + 0.0722f * color.b;
+}
+
+static bool
+isEmissive(const mnMaterial& material) {
+    return (material.emissionPower > 0.f && fsMax(material.emissionColor.r, fsMax(material.emissionColor.g, material.emissionColor.b)) > 0.f);
+}
+
+/*! @brief Rounds \c value to one of the two nearest floats that half precision holds exactly, picking the upper one with
+    probability in proportion to how close it is, from the 13 low bits of \c noise. Unlike rounding to nearest, the result
+    is \c value on average. */
+static fsr32
+roundForHalfStochastic(fsr32 value, fsu32 noise) {
+    union { fsr32 f; fsu32 u; } x = {value};
+    // Adding noise below the half mantissa then truncating rounds the magnitude up with the right probability; a carry out of
+    // the mantissa correctly moves to the next power of two. Infinities and NaNs are left alone.
+    if ((x.u & 0x7f800000u) != 0x7f800000u) {
+        x.u = (x.u + (noise & 0x1fffu)) & ~0x1fffu;
+    }
+    return x.f;
 }
 
-static fsv3f
-randomInUnitSphere(fsu32& seed) {
-    return fs_vnormalize(fsv3f_random(seed));
+/*! @brief Weight of a sample from strategy \c pdfA when strategy \c pdfB could also have produced it. */
+static fsr32
+powerHeuristic(fsr32 pdfA, fsr32 pdfB) {
+    fsr32 a = pdfA * pdfA;
+    fsr32 b = pdfB * pdfB;
+    return (a + b > 0.f ? a / (a + b) : 0.f);
+}
+
+/*! @brief 1 - cos of the half-angle of the cone that a sphere subtends, or 0 if \c distanceSq is inside the sphere.
+    Written as sin^2 / (1 + cos) so that small, distant spheres don't lose all their precision to cancellation. */
+static fsr32
+coneOneMinusCos(fsr32 radiusSq, fsr32 distanceSq) {
+    if (distanceSq <= radiusSq) {
+        return 0.f;
+    }
+    fsr32 sinThetaMaxSq = radiusSq / distanceSq;
+    fsr32 cosThetaMax = sqrtf(fsMax(0.f, 1.f - sinThetaMaxSq));
+    return sinThetaMaxSq / (1.f + cosThetaMax);
 }
 
 mnImage*
 mnRenderer::render(const mnScene& scene, const mnCamera& camera) {
+    if (_image) {
+        _resolveTarget = {(fsu8 *)_image->pixelData, _image->width * sizeof(fsu32), mnPixelFormat::rgba32};
+    }
+    renderFrame(scene, camera);
+    return _image;
+}
+
+void
+mnRenderer::renderInto(const mnScene& scene, const mnCamera& camera, void *pixels, size_t stride, mnPixelFormat format) {
+    _resolveTarget = {(fsu8 *)pixels, stride, format};
+    renderFrame(scene, camera);
+}
+
+void
+mnRenderer::renderFrame(const mnScene& scene, const mnCamera& camera) {
     fsTimingToken *start = fs_timing_start();
+    bool dynamicFrame = false;
     if (_image) {
         _activeScene = &scene;
         _activeCamera = &camera;
+        _rayDirectionTable = (_settings.precomputedRayDirections ? camera.getRayDirections().data() : nullptr);
+        syncScene(scene);
+        _sampler.configure(_settings.samplerType, _image->width);
+        
+        if (&camera != _primaryHitCamera) {
+            _primaryHitCamera = &camera;
+            _primaryHitsValid = false;
+        }
         
-        if (_frameIndex == 1) {
-            fs_memclear(_accumulationData, _image->width * _image->height * sizeof(fsv4f));
+        _threadPool.setWorkerCount(_settings.threadCount);
+        _workerStats.resize(_threadPool.getWorkerCount());
+        for (WorkerStats& workerStats : _workerStats) {
+            workerStats.stats = {};
         }
         
-        // NOTE(christian): TheCherno uses a parallel for_each loop here, which requires C++17. I am on an older iMac, however, which does not allow me to update to the newest Xcode, and my current version
-        // of Xcode (12) does not have support for C++17. As a replacement, I'm using Apple's GCD library to multithread the following code with very good, comparable results to what TheCherno achieved
-        // with parallel for_each.
-        dispatch_queue_t queue = dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0);
-        dispatch_group_t group = dispatch_group_create();
+        AccumulationFormat accumulationFormat = getAccumulationFormat();
+        if (accumulationFormat != _accumulationFormat) {
+            allocateAccumulation(accumulationFormat);
+            _frameIndex = 1;
+        }
         
-        for (fsu32 y = 0; y < _image->height; ++y) {
-            dispatch_group_async(group, queue, ^{
-                for (fsu32 x = 0; x < _image->width; ++x) {
-                    fsv4f color = perPixel(x, y);
-                    _accumulationData[x + (y * _image->width)] += color;
+        // NOTE(christian): Moving frames don't touch the accumulation, so the first frame after the camera stops still starts
+        // from scratch (or from the reprojected history) at full resolution.
+        dynamicFrame = (_settings.dynamicResolution && _cameraMoving);
+        _cameraMoving = _cameraMovingHeld;
+        if (dynamicFrame) {
+            _resolutionStride = (fsu32)ceilf(1.f / _resolutionScale - 0.001f);
+            renderDynamicResolution(_resolutionStride);
+            _framePassCount = 1;
+        } else {
+            _resolutionStride = 1;
+            renderFullResolution();
+        }
+        
+        _stats = {};
+        for (const WorkerStats& workerStats : _workerStats) {
+            mn_stats_merge(_stats, workerStats.stats);
+        }
+    }
+    
+    if (!_settings.accumulate) {
+        _frameIndex = 1;
+    }
+    
+    lastRenderTime = fs_timing_stop(start);
+    
+    if (dynamicFrame) {
+        // NOTE(christian): Tracing cost goes with the pixel count, i.e. the square of the scale, so this is the scale that
+        // would have just met the budget. Steps are limited to keep one unusual frame from swinging it too far.
+        fsr32 scale = sqrtf(_settings.dynamicResolutionBudget / fsMax((fsr32)lastRenderTime, 0.001f)) / _resolutionStride;
+        scale = fsClamp(scale, _resolutionScale * 0.5f, _resolutionScale * 1.25f);
+        _resolutionScale = fsClamp(scale, fsClamp(_settings.dynamicResolutionMinScale, 0.01f, 1.f), 1.f);
+    }
+}
 
-                    fsv4f accumulatedColor = _accumulationData[x + (y * _image->width)];
-                    accumulatedColor /= (fsr32)_frameIndex;
+void
+mnRenderer::renderFullResolution() {
+    // NOTE(christian): Passes are added while the last one's cost still fits in what's left of the budget. With adaptive
+    // sampling the cost falls as pixels converge, so the prediction tracks the most recent pass rather than the first.
+    fsr64 elapsed = 0.0;
+    _framePassCount = 0;
+    do {
+        fsTimingToken *start = fs_timing_start();
+        renderPass();
+        fsr64 passTime = fs_timing_stop(start);
+        elapsed += passTime;
+        ++_framePassCount;
+        
+        if (_settings.adaptiveSampling && _settings.accumulate && _activePixelCount == 0) {
+            break;
+        }
+        if (elapsed + passTime > _settings.frameTimeBudget) {
+            break;
+        }
+    } while (_framePassCount < kMaxPassesPerFrame);
+    
+    resolveImage();
+}
+
+void
+mnRenderer::renderPass() {
+    fsu32 pixelCount = _image->width * _image->height;
+    if (_settings.temporalReprojection && _surfaces.size() != pixelCount) {
+        _surfaces.resize(pixelCount);
+        _historySurfaces.resize(pixelCount);
+        _historyMoments.resize(pixelCount);
+        _historyData = new fsv4f[pixelCount];
+        _historyValid = false;
+    }
+    
+    if (_frameIndex == 1) {
+        _reprojecting = (_reprojectPending && _historyValid && _settings.temporalReprojection);
+        if (_reprojecting) {
+            fsSwap(_accumulationData, _historyData);
+            _luminanceMoments.swap(_historyMoments);
+            _surfaces.swap(_historySurfaces);
+            for (fsu32 row = 0; row < 3; ++row) {
+                _historyRayBasis[row] = _rayBasis[row];
+            }
+            _historyCameraPosition = _cameraPosition;
+            
+            // NOTE(christian): Move the sample indices past any the history could have used, so the new frame's noise
+            // doesn't repeat it.
+            _sampleIndexBase += _accumulatedSamples * fsMax(_settings.adaptiveMaxBoost, 1u) + (fsu32)_settings.reprojectionMaxHistory + 1;
+        } else {
+            _sampleIndexBase = 0;
+        }
+        _reprojectPending = false;
+        
+        if (_accumulationData) {
+            fs_memclear(_accumulationData, pixelCount * sizeof(fsv4f));
+        }
+        if (_accumulationRGB) {
+            fs_memclear(_accumulationRGB, pixelCount * 3 * sizeof(fsr32));
+        }
+        if (_accumulationHalf) {
+            fs_memclear(_accumulationHalf, pixelCount * 4 * sizeof(fsu16));
+        }
+        std::fill(_luminanceMoments.begin(), _luminanceMoments.end(), 0.f);
+        std::fill(_pixelConverged.begin(), _pixelConverged.end(), 0);
+        std::fill(_tileConverged.begin(), _tileConverged.end(), 0);
+        _activePixelCount = pixelCount;
+    }
+    
+    // NOTE(christian): The cache can only be filled by a frame that traces every pixel, so not while adaptive sampling is
+    // skipping converged ones.
+    if (!_settings.cachePrimaryHits) {
+        _primaryHitCache = PrimaryHitCache::none;
+    } else if (_primaryHitsValid) {
+        _primaryHitCache = PrimaryHitCache::reuse;
+    } else {
+        _primaryHitCache = (_activePixelCount == pixelCount ? PrimaryHitCache::fill : PrimaryHitCache::none);
+        _primaryHits.resize(pixelCount);
+    }
+    
+    fsu32 sampleCount = fsMax(_settings.samplesPerPixel, 1u);
+    bool adaptive = (_settings.adaptiveSampling && _settings.accumulate);
+    _uniformSampleCount = (fsr32)(_frameIndex - 1);
+    
+    // Spread the frame's nominal budget over the pixels that are still noisy, up to the boost limit.
+    fsu32 activeSampleCount = sampleCount;
+    if (adaptive && _activePixelCount > 0) {
+        fsu64 budget = (fsu64)pixelCount * sampleCount;
+        fsu64 maxSampleCount = (fsu64)sampleCount * fsMax(_settings.adaptiveMaxBoost, 1u);
+        activeSampleCount = (fsu32)fsClamp(budget / _activePixelCount, (fsu64)sampleCount, maxSampleCount);
+    }
+    
+    _activeTiles.clear();
+    for (fsu32 tileIndex = 0; tileIndex < _tiles.size(); ++tileIndex) {
+        if (!adaptive || !_tileConverged[tileIndex]) {
+            _activeTiles.push_back(tileIndex);
+        }
+    }
+    
+    if (_settings.executionMode == ExecutionMode::wavefront) {
+        renderWavefront(activeSampleCount, adaptive);
+    } else {
+        renderMegakernel(activeSampleCount, adaptive);
+    }
+    
+    _activePixelCount = 0;
+    for (fsu32 tileIndex : _activeTiles) {
+        _activePixelCount += _tileActivePixels[tileIndex];
+    }
+    
+    _primaryHitsValid |= (_primaryHitCache == PrimaryHitCache::fill);
+    
+    _activeCamera->getInverseRayBasis(_rayBasis);
+    _cameraPosition = _activeCamera->getPosition();
+    _historyValid = _settings.temporalReprojection;
+    _reprojecting = false;
+    
+    _accumulatedSamples = _frameIndex + sampleCount - 1;
+    _frameIndex += sampleCount;
+}
+
+void
+mnRenderer::renderMegakernel(fsu32 sampleCount, bool adaptive) {
+    bool reusePrimaryHits = (_primaryHitCache == PrimaryHitCache::reuse);
+    bool fillPrimaryHits = (_primaryHitCache == PrimaryHitCache::fill);
+    bool tracePackets = (_settings.primaryRayPackets && !reusePrimaryHits);
+    bool recordSurfaces = _settings.temporalReprojection;
+    
+    _threadPool.run((fsu32)_activeTiles.size(), [=](fsu32 jobIndex, fsu32 workerIndex) {
+        fsu32 tileIndex = _activeTiles[jobIndex];
+        const mnTile& tile = _tiles[tileIndex];
+        mnRenderStats& stats = _workerStats[workerIndex].stats;
+        fsu32 activePixels = 0;
+        
+        // NOTE(christian): Pixels are visited in packet-sized blocks. Camera rays don't change between samples, so a block's
+        // primary hits are traced once as a packet (or come from the cache) and are shared by all of the frame's samples.
+        mnRayPacket packet;
+        fsu32 packetPixels[mnRayPacket::kMaxRayCount];
+        fsr32 directionX[kPacketSize + FS_SIMD_WIDTH], directionY[kPacketSize + FS_SIMD_WIDTH], directionZ[kPacketSize + FS_SIMD_WIDTH];
+        mnRay ray;
+        ray.origin = _activeCamera->getPosition();
+        for (fsu32 blockY = tile.y0; blockY < tile.y1; blockY += kPacketSize) {
+            for (fsu32 blockX = tile.x0; blockX < tile.x1; blockX += kPacketSize) {
+                packet.clear();
+                fsu32 blockWidth = fsMin(blockX + kPacketSize, tile.x1) - blockX;
+                for (fsu32 y = blockY; y < fsMin(blockY + kPacketSize, tile.y1); ++y) {
+                    getPrimaryRayDirections(blockX, y, blockWidth, directionX, directionY, directionZ);
+                    for (fsu32 i = 0; i < blockWidth; ++i) {
+                        fsu32 pixelIndex = blockX + i + (y * _image->width);
+                        if (adaptive && _pixelConverged[pixelIndex]) {
+                            continue;
+                        }
+                        
+                        ray.direction = {directionX[i], directionY[i], directionZ[i]};
+                        packetPixels[packet.addRay(ray, FLT_MAX)] = pixelIndex;
+                    }
+                }
+                
+                if (packet.count == 0) {
+                    continue;
+                }
+                if (tracePackets) {
+                    tracePacket(packet, stats);
+                }
+                
+                for (fsu32 i = 0; i < packet.count; ++i) {
+                    fsu32 pixelIndex = packetPixels[i];
+                    fsu32 x = pixelIndex % _image->width;
+                    fsu32 y = pixelIndex / _image->width;
+                    HitPayload primaryHit;
+                    const HitPayload *primary = nullptr;
+                    if (reusePrimaryHits) {
+                        primary = &_primaryHits[pixelIndex];
+                    } else if (tracePackets) {
+                        primaryHit = getPacketHit(packet, i);
+                        primary = &primaryHit;
+                    } else if (fillPrimaryHits || recordSurfaces) {
+                        primaryHit = traceRay(packet.getRay(i), 0, stats);
+                        primary = &primaryHit;
+                    }
+                    if (fillPrimaryHits) {
+                        _primaryHits[pixelIndex] = *primary;
+                    }
+                    if (recordSurfaces) {
+                        _surfaces[pixelIndex] = {primary->hitDistance, primary->objectIndex};
+                    }
+                    
+                    // NOTE(christian): Sample indices continue from the pixel's own count, since pixels can differ in how
+                    // many samples they've taken once adaptive sampling is on.
+                    fsu32 pixelSamples = _sampleIndexBase + (fsu32)getPixelSampleCount(pixelIndex);
+                    fsv4f color = {};
+                    fsr32 luminanceSq = 0.f;
+                    for (fsu32 sample = 0; sample < sampleCount; ++sample) {
+                        fsv4f sampleColor = perPixel(x, y, pixelSamples + sample + 1, primary, stats);
+                        fsr32 sampleLuminance = luminance(sampleColor);
+                        color += sampleColor;
+                        luminanceSq += sampleLuminance * sampleLuminance;
+                    }
+                    if (_reprojecting) {
+                        reprojectPixel(pixelIndex);
+                    }
+                    accumulatePixel(pixelIndex, color.xyz, color.a);
+                    _luminanceMoments[pixelIndex] += luminanceSq;
+                    
+                    activePixels += updatePixelConvergence(pixelIndex, adaptive);
+                }
+            }
+        }
+        
+        finishTile(tileIndex, activePixels, adaptive);
+    });
+    _uniformSampleCount += (fsr32)sampleCount;
+}
 
-                    accumulatedColor = fs_vclamp01(accumulatedColor);
-                    _image->pixelData[x + (y * _image->width)] = convertToRGBA(accumulatedColor);
+void
+mnRenderer::renderWavefront(fsu32 sampleCount, bool adaptive) {
+    // NOTE(christian): resize allocates these when wavefront mode is already on; this covers switching modes at runtime.
+    fsu32 pixelCount = _image->width * _image->height;
+    _pathQueues[0].reserve(pixelCount);
+    _pathQueues[1].reserve(pixelCount);
+    _pathRadiance.resize(pixelCount);
+    
+    // NOTE(christian): One path per active pixel is in flight at a time, so a frame of several samples is several passes,
+    // each accumulated before the next one starts. This keeps the queues at one entry per pixel.
+    for (fsu32 sample = 0; sample < sampleCount; ++sample) {
+        mnPathQueue *queue = &_pathQueues[0];
+        mnPathQueue *nextQueue = &_pathQueues[1];
+        generatePaths(*queue, adaptive);
+        
+        for (fsu32 depth = 0; depth < _settings.maxBounces; ++depth) {
+            fsu32 pathCount = queue->count;
+            if (pathCount == 0) {
+                break;
+            }
+            
+            fsu32 jobCount = (pathCount + kWavefrontChunkSize - 1) / kWavefrontChunkSize;
+            nextQueue->count = 0;
+            
+            // Intersect. Generated paths are in tile order, so runs of primary rays are coherent enough to trace as packets.
+            _threadPool.run(jobCount, [this, queue, pathCount, depth](fsu32 jobIndex, fsu32 workerIndex) {
+                mnRenderStats& stats = _workerStats[workerIndex].stats;
+                fsu32 end = fsMin((jobIndex + 1) * kWavefrontChunkSize, pathCount);
+                if (depth == 0 && _primaryHitCache == PrimaryHitCache::reuse) {
+                    for (fsu32 i = jobIndex * kWavefrontChunkSize; i < end; ++i) {
+                        const HitPayload& primaryHit = _primaryHits[queue->pixelIndex[i]];
+                        queue->hitDistance[i] = primaryHit.hitDistance;
+                        queue->objectIndex[i] = primaryHit.objectIndex;
+                    }
+                } else if (depth == 0 && _settings.primaryRayPackets) {
+                    mnRayPacket packet;
+                    for (fsu32 first = jobIndex * kWavefrontChunkSize; first < end; first += mnRayPacket::kMaxRayCount) {
+                        packet.clear();
+                        for (fsu32 i = first; i < fsMin(first + mnRayPacket::kMaxRayCount, end); ++i) {
+                            packet.addRay(queue->getRay(i), FLT_MAX);
+                        }
+                        tracePacket(packet, stats);
+                        for (fsu32 i = 0; i < packet.count; ++i) {
+                            queue->hitDistance[first + i] = packet.hitDistance[i];
+                            queue->objectIndex[first + i] = packet.hitObject[i];
+                        }
+                    }
+                } else {
+                    for (fsu32 i = jobIndex * kWavefrontChunkSize; i < end; ++i) {
+                        stats.rayCount++;
+                        mnStat(stats.raysPerDepth[fsMin(depth, (fsu32)MN_STATS_MAX_DEPTH - 1)]++);
+                        intersectScene(queue->getRay(i), queue->hitDistance[i], queue->objectIndex[i], stats);
+                    }
+                }
+                
+                if (depth == 0 && _primaryHitCache == PrimaryHitCache::fill) {
+                    for (fsu32 i = jobIndex * kWavefrontChunkSize; i < end; ++i) {
+                        mnRay ray = queue->getRay(i);
+                        _primaryHits[queue->pixelIndex[i]] = (queue->objectIndex[i] >= 0 ?
+                                                              closestHit(ray, queue->hitDistance[i], queue->objectIndex[i]) : miss(ray));
+                    }
+                }
+                
+                if (depth == 0 && _settings.temporalReprojection) {
+                    for (fsu32 i = jobIndex * kWavefrontChunkSize; i < end; ++i) {
+                        _surfaces[queue->pixelIndex[i]] = {queue->hitDistance[i], queue->objectIndex[i]};
+                    }
                 }
             });
+            
+            // Shade and scatter, compacting the survivors into the next queue.
+            shadePaths(depth, *queue, *nextQueue);
+            
+            // Trace the shadow rays from the shading stage.
+            if (_settings.nextEventEstimation && !_emissiveSpheres.empty()) {
+                _threadPool.run(jobCount, [this, queue, pathCount](fsu32 jobIndex, fsu32 workerIndex) {
+                    mnRenderStats& stats = _workerStats[workerIndex].stats;
+                    fsu32 end = fsMin((jobIndex + 1) * kWavefrontChunkSize, pathCount);
+                    for (fsu32 i = jobIndex * kWavefrontChunkSize; i < end; ++i) {
+                        if (queue->shadowDistance[i] <= 0.f) {
+                            continue;
+                        }
+                        
+                        mnRay shadowRay;
+                        shadowRay.origin = {queue->shadowOriginX[i], queue->shadowOriginY[i], queue->shadowOriginZ[i]};
+                        shadowRay.direction = {queue->shadowDirectionX[i], queue->shadowDirectionY[i], queue->shadowDirectionZ[i]};
+                        if (!traceShadowRay(shadowRay, queue->shadowDistance[i], stats)) {
+                            _pathRadiance[queue->pixelIndex[i]] += fsv3f{queue->shadowR[i], queue->shadowG[i], queue->shadowB[i]};
+                        }
+                    }
+                });
+            }
+            
+            std::swap(queue, nextQueue);
         }
         
-        dispatch_group_wait(group, DISPATCH_TIME_FOREVER);
+        // Accumulate.
+        bool reproject = (_reprojecting && sample == 0);
+        bool lastSample = (sample == sampleCount - 1);
+        _threadPool.run((fsu32)_activeTiles.size(), [this, adaptive, reproject, lastSample](fsu32 jobIndex, fsu32 workerIndex) {
+            fsu32 tileIndex = _activeTiles[jobIndex];
+            const mnTile& tile = _tiles[tileIndex];
+            fsu32 activePixels = 0;
+            for (fsu32 y = tile.y0; y < tile.y1; ++y) {
+                for (fsu32 x = tile.x0; x < tile.x1; ++x) {
+                    fsu32 pixelIndex = x + (y * _image->width);
+                    if (adaptive && _pixelConverged[pixelIndex]) {
+                        continue;
+                    }
+                    
+                    const fsv3f& radiance = _pathRadiance[pixelIndex];
+                    fsv4f sampleColor = {radiance.r, radiance.g, radiance.b, 1.f};
+                    fsr32 sampleLuminance = luminance(sampleColor);
+                    if (reproject) {
+                        reprojectPixel(pixelIndex);
+                    }
+                    accumulatePixel(pixelIndex, radiance, 1.f);
+                    _luminanceMoments[pixelIndex] += sampleLuminance * sampleLuminance;
+                    
+                    if (lastSample) {
+                        activePixels += updatePixelConvergence(pixelIndex, adaptive);
+                    }
+                }
+            }
+            
+            if (lastSample) {
+                finishTile(tileIndex, activePixels, adaptive);
+            }
+        });
+        _uniformSampleCount += 1.f;
     }
+}
+
+void
+mnRenderer::generatePaths(mnPathQueue& queue, bool adaptive) {
+    queue.count = 0;
     
-    if (_settings.accumulate) {
-        _frameIndex++;
-    } else {
-        _frameIndex = 1;
+    _threadPool.run((fsu32)_activeTiles.size(), [this, &queue, adaptive](fsu32 jobIndex, fsu32 workerIndex) {
+        const mnTile& tile = _tiles[_activeTiles[jobIndex]];
+        fsu32 pathCount = 0;
+        for (fsu32 y = tile.y0; y < tile.y1; ++y) {
+            for (fsu32 x = tile.x0; x < tile.x1; ++x) {
+                pathCount += !(adaptive && _pixelConverged[x + (y * _image->width)]);
+            }
+        }
+        
+        fsu32 index = queue.count.fetch_add(pathCount);
+        fsr32 directionX[kTileSize + FS_SIMD_WIDTH], directionY[kTileSize + FS_SIMD_WIDTH], directionZ[kTileSize + FS_SIMD_WIDTH];
+        mnRay ray;
+        ray.origin = _activeCamera->getPosition();
+        for (fsu32 y = tile.y0; y < tile.y1; ++y) {
+            getPrimaryRayDirections(tile.x0, y, tile.x1 - tile.x0, directionX, directionY, directionZ);
+            for (fsu32 x = tile.x0; x < tile.x1; ++x) {
+                fsu32 pixelIndex = x + (y * _image->width);
+                if (adaptive && _pixelConverged[pixelIndex]) {
+                    continue;
+                }
+                
+                // Same sample index as perPixel, so both modes trace the same paths.
+                ray.direction = {directionX[x - tile.x0], directionY[x - tile.x0], directionZ[x - tile.x0]};
+                queue.pixelIndex[index] = pixelIndex;
+                queue.sampleIndex[index] = _sampleIndexBase + (fsu32)getPixelSampleCount(pixelIndex);
+                queue.setRay(index, ray);
+                queue.setThroughput(index, {1.f, 1.f, 1.f});
+                queue.bsdfPdf[index] = 0.f;
+                _pathRadiance[pixelIndex] = {};
+                index++;
+            }
+        }
+    });
+}
+
+void
+mnRenderer::shadePaths(fsu32 depth, mnPathQueue& queue, mnPathQueue& nextQueue) {
+    fsu32 pathCount = queue.count;
+    fsu32 jobCount = (pathCount + kWavefrontChunkSize - 1) / kWavefrontChunkSize;
+    bool sampleLights = (_settings.nextEventEstimation && !_emissiveSpheres.empty());
+    bool lastBounce = (depth == _settings.maxBounces - 1);
+    
+    _threadPool.run(jobCount, [&, pathCount](fsu32 jobIndex, fsu32 workerIndex) {
+        mnRenderStats& stats = _workerStats[workerIndex].stats;
+        fsu32 survivors[kWavefrontChunkSize];
+        fsu32 survivorCount = 0;
+        
+        fsu32 end = fsMin((jobIndex + 1) * kWavefrontChunkSize, pathCount);
+        for (fsu32 i = jobIndex * kWavefrontChunkSize; i < end; ++i) {
+            queue.shadowDistance[i] = 0.f;
+            
+            if (queue.objectIndex[i] < 0) {
+                mnStat(stats.pathsEscaped++);
+                continue;
+            }
+            
+            mnRay ray = queue.getRay(i);
+            HitPayload payload = closestHit(ray, queue.hitDistance[i], queue.objectIndex[i]);
+            const mnMaterial& material = _activeScene->materials[payload.materialIndex];
+            
+            fsv3f contribution = queue.getThroughput(i);
+            fsv3f& radiance = _pathRadiance[queue.pixelIndex[i]];
+            radiance += fs_vhadamard(emittedLight(ray, payload, material, depth, queue.bsdfPdf[i]), contribution);
+            
+            mnRay shadowRay;
+            fsr32 shadowDistance;
+            fsv3f directLight;
+            mnSamplerState samples = {queue.pixelIndex[i], queue.sampleIndex[i], depth * kDimensionsPerBounce};
+            mnBSDF bsdf(material, payload.worldNormal, -ray.direction);
+            if (sampleLights && sampleDirectLight(payload, bsdf, samples, shadowRay, shadowDistance, directLight)) {
+                directLight = fs_vhadamard(directLight, contribution);
+                queue.shadowOriginX[i] = shadowRay.origin.x;
+                queue.shadowOriginY[i] = shadowRay.origin.y;
+                queue.shadowOriginZ[i] = shadowRay.origin.z;
+                queue.shadowDirectionX[i] = shadowRay.direction.x;
+                queue.shadowDirectionY[i] = shadowRay.direction.y;
+                queue.shadowDirectionZ[i] = shadowRay.direction.z;
+                queue.shadowDistance[i] = shadowDistance;
+                queue.shadowR[i] = directLight.r, queue.shadowG[i] = directLight.g, queue.shadowB[i] = directLight.b;
+            }
+            
+            fsr32 bsdfPdf;
+            if (!scatter(payload, bsdf, depth, samples, contribution, ray, bsdfPdf, stats)) {
+                continue;
+            }
+            
+            if (lastBounce) {
+                mnStat(stats.pathsTerminatedByDepth++);
+                continue;
+            }
+            
+            // The scattered path overwrites this entry, which the next queue then copies.
+            queue.setRay(i, ray);
+            queue.setThroughput(i, contribution);
+            queue.bsdfPdf[i] = bsdfPdf;
+            survivors[survivorCount++] = i;
+        }
+        
+        fsu32 index = nextQueue.count.fetch_add(survivorCount);
+        for (fsu32 survivor = 0; survivor < survivorCount; ++survivor) {
+            nextQueue.copyPath(index + survivor, queue, survivors[survivor]);
+        }
+    });
+}
+
+void
+mnRenderer::renderDynamicResolution(fsu32 stride) {
+    fsu32 width = _image->width;
+    fsu32 lowWidth = (width + stride - 1) / stride;
+    fsu32 lowHeight = (_image->height + stride - 1) / stride;
+    _lowResolutionData.resize(lowWidth * lowHeight);
+    
+    // NOTE(christian): Samples are a pure function of their index, so without moving the indices on every frame, the noise
+    // would stay fixed in place on screen for as long as the camera moves.
+    fsu32 sampleCount = fsMax(_settings.samplesPerPixel, 1u);
+    fsu32 firstSample = _sampleIndexBase + _movingFrameIndex * sampleCount + 1;
+    ++_movingFrameIndex;
+    _threadPool.run(lowHeight, [=](fsu32 lowY, fsu32 workerIndex) {
+        mnRenderStats& stats = _workerStats[workerIndex].stats;
+        mnRay ray;
+        ray.origin = _activeCamera->getPosition();
+        fsu32 y = lowY * stride;
+        for (fsu32 lowX = 0; lowX < lowWidth; ++lowX) {
+            fsu32 x = lowX * stride;
+            ray.direction = (_rayDirectionTable ? _rayDirectionTable[x + y * width] : _activeCamera->getRayDirection(x, y));
+            HitPayload primaryHit = traceRay(ray, 0, stats);
+            
+            fsv4f color = {};
+            for (fsu32 sample = 0; sample < sampleCount; ++sample) {
+                color += perPixel(x, y, firstSample + sample, &primaryHit, stats);
+            }
+            color *= 1.f / sampleCount;
+            color.a = (primaryHit.hitDistance < 0.f ? FLT_MAX : primaryHit.hitDistance);
+            _lowResolutionData[lowX + lowY * lowWidth] = color;
+        }
+    });
+    
+    _threadPool.run(_image->height, [=](fsu32 y, fsu32) {
+        upscaleRow(y, stride);
+    });
+    
+    // The upscale wrote over the whole target, so the next full resolution frame has to resolve all of it again, as does
+    // every other target that has yet to catch up with this frame.
+    std::fill(_tileChangeFrames.begin(), _tileChangeFrames.end(), _resolveFrame);
+}
+
+void
+mnRenderer::upscaleRow(fsu32 y, fsu32 stride) {
+    fsu32 width = _image->width;
+    fsu32 lowWidth = (width + stride - 1) / stride;
+    fsu32 lowHeight = (_image->height + stride - 1) / stride;
+    fsr32 inverseStride = 1.f / stride;
+    fsr32 tolerance = fsMax(_settings.dynamicResolutionDepthTolerance, 0.001f);
+    
+    fsu32 y0 = y / stride;
+    fsu32 y1 = fsMin(y0 + 1, lowHeight - 1);
+    fsr32 fy = (y % stride) * inverseStride;
+    const fsv4f *row0 = _lowResolutionData.data() + y0 * lowWidth;
+    const fsv4f *row1 = _lowResolutionData.data() + y1 * lowWidth;
+    fsu32 *pixels = (fsu32 *)(_resolveTarget.pixels + y * _resolveTarget.stride);
+    
+    // The row is upscaled and resolved a tile's width at a time, as weighted sums the resolve kernel divides out.
+    fsr32 red[kTileSize], green[kTileSize], blue[kTileSize], totalWeight[kTileSize];
+    for (fsu32 start = 0; start < width; start += kTileSize) {
+        fsu32 count = fsMin(width - start, kTileSize);
+        for (fsu32 i = 0; i < count; ++i) {
+            fsu32 x = start + i;
+            fsu32 x0 = x / stride;
+            fsu32 x1 = fsMin(x0 + 1, lowWidth - 1);
+            fsr32 fx = (x % stride) * inverseStride;
+            const fsv4f *taps[4] = {&row0[x0], &row0[x1], &row1[x0], &row1[x1]};
+            fsr32 weights[4] = {(1.f - fx) * (1.f - fy), fx * (1.f - fy), (1.f - fx) * fy, fx * fy};
+            
+            // NOTE(christian): Bilinear, but only over the taps at about the same depth as the nearest one, so silhouettes
+            // stay sharp instead of blending foreground into background. Misses have FLT_MAX depth, which only matches
+            // other misses.
+            fsr32 referenceDepth = taps[(fx > 0.5f) + 2 * (fy > 0.5f)]->a;
+            fsr32 depthLimit = tolerance * referenceDepth;
+            fsv3f color = {};
+            fsr32 weightSum = 0.f;
+            for (fsu32 tap = 0; tap < 4; ++tap) {
+                fsr32 weight = (fabsf(taps[tap]->a - referenceDepth) <= depthLimit ? weights[tap] : 0.f);
+                color += taps[tap]->xyz * weight;
+                weightSum += weight;
+            }
+            
+            red[i] = color.r;
+            green[i] = color.g;
+            blue[i] = color.b;
+            totalWeight[i] = weightSum;
+        }
+        mn_resolve_pixels(red, green, blue, totalWeight, count, _settings.toneMapper, _resolveTarget.format, pixels + start);
     }
+}
+
+mnRenderer::AccumulationFormat
+mnRenderer::getAccumulationFormat() const {
+    bool perPixelCounts = ((_settings.adaptiveSampling && _settings.accumulate) || _settings.temporalReprojection);
+    return (perPixelCounts ? AccumulationFormat::rgba32f : _settings.accumulationFormat);
+}
+
+void
+mnRenderer::allocateAccumulation(AccumulationFormat format) {
+    delete [] _accumulationData;
+    delete [] _accumulationRGB;
+    delete [] _accumulationHalf;
+    _accumulationData = nullptr;
+    _accumulationRGB = nullptr;
+    _accumulationHalf = nullptr;
+    _accumulationFormat = format;
     
-    lastRenderTime = fs_timing_stop(start);
+    fsu32 pixelCount = _image->width * _image->height;
+    switch (format) {
+        case AccumulationFormat::rgba32f: _accumulationData = new fsv4f[pixelCount]; break;
+        case AccumulationFormat::rgb32f: _accumulationRGB = new fsr32[pixelCount * 3]; break;
+        case AccumulationFormat::rgba16f: _accumulationHalf = new fsu16[pixelCount * 4]; break;
+    }
+}
+
+fsr32
+mnRenderer::getPixelSampleCount(fsu32 pixelIndex) const {
+    return (_accumulationData ? _accumulationData[pixelIndex].a : _uniformSampleCount);
+}
+
+fsv3f
+mnRenderer::getPixelMean(fsu32 pixelIndex) const {
+    switch (_accumulationFormat) {
+        case AccumulationFormat::rgba32f: {
+            const fsv4f& sum = _accumulationData[pixelIndex];
+            return (sum.a > 0.f ? sum.xyz * (1.f / sum.a) : (fsv3f){});
+        }
+        case AccumulationFormat::rgb32f: {
+            const fsr32 *sum = _accumulationRGB + pixelIndex * 3;
+            fsr32 inverseSampleCount = (_uniformSampleCount > 0.f ? 1.f / _uniformSampleCount : 0.f);
+            return {sum[0] * inverseSampleCount, sum[1] * inverseSampleCount, sum[2] * inverseSampleCount};
+        }
+        case AccumulationFormat::rgba16f: {
+            fsr32 mean[4];
+            fs_half4_to_float4(_accumulationHalf + pixelIndex * 4, mean);
+            return {mean[0], mean[1], mean[2]};
+        }
+    }
+    return {};
+}
+
+void
+mnRenderer::accumulatePixel(fsu32 pixelIndex, const fsv3f& sum, fsr32 sampleCount) {
+    switch (_accumulationFormat) {
+        case AccumulationFormat::rgba32f:
+            _accumulationData[pixelIndex] += (fsv4f){sum.r, sum.g, sum.b, sampleCount};
+            break;
+        case AccumulationFormat::rgb32f: {
+            fsr32 *accumulated = _accumulationRGB + pixelIndex * 3;
+            accumulated[0] += sum.r;
+            accumulated[1] += sum.g;
+            accumulated[2] += sum.b;
+            break;
+        }
+        case AccumulationFormat::rgba16f: {
+            // NOTE(christian): A growing sum would soon run out of half precision, so this keeps the mean instead, which
+            // stays in the range of the radiance itself. Once a sample's change to the mean drops below half a ULP, rounding
+            // to nearest would throw away every ordinary sample and keep only the outliers, biasing the mean upward. So the
+            // mean is rounded stochastically, which is unbiased, and its history is weighted as at most
+            // kHalfAccumulationMaxWeight samples, which bounds the rounding noise that builds up.
+            fsu16 *accumulated = _accumulationHalf + pixelIndex * 4;
+            fsr32 mean[4];
+            fs_half4_to_float4(accumulated, mean);
+            fsr32 historyWeight = fsMin(_uniformSampleCount, kHalfAccumulationMaxWeight);
+            fsr32 inverseWeight = 1.f / (historyWeight + sampleCount);
+            fsr32 oldWeight = historyWeight * inverseWeight;
+            fsu32 seed = fs_random_wang_hash(pixelIndex ^ fs_random_wang_hash((fsu32)_uniformSampleCount));
+            mean[0] = roundForHalfStochastic(mean[0] * oldWeight + sum.r * inverseWeight, seed);
+            mean[1] = roundForHalfStochastic(mean[1] * oldWeight + sum.g * inverseWeight, fs_random_wang_hash(seed + 1));
+            mean[2] = roundForHalfStochastic(mean[2] * oldWeight + sum.b * inverseWeight, fs_random_wang_hash(seed + 2));
+            mean[3] = 1.f;
+            fs_float4_to_half4(mean, accumulated);
+            break;
+        }
+    }
+}
+
+bool
+mnRenderer::updatePixelConvergence(fsu32 pixelIndex, bool adaptive) {
+    if (adaptive && isPixelConverged(pixelIndex)) {
+        _pixelConverged[pixelIndex] = 1;
+        return false;
+    }
+    return true;
+}
+
+void
+mnRenderer::reprojectPixel(fsu32 pixelIndex) {
+    const Surface& surface = _surfaces[pixelIndex];
+    if (surface.objectIndex < 0) {
+        return;
+    }
     
-    return _image;
+    fsi32 width = _image->width;
+    fsi32 height = _image->height;
+    fsu32 x = pixelIndex % width;
+    fsu32 y = pixelIndex / width;
+    fsv3f direction = (_rayDirectionTable ? _rayDirectionTable[pixelIndex] : _activeCamera->getRayDirection(x, y));
+    fsv3f position = _activeCamera->getPosition() + direction * surface.depth;
+    
+    // Where the surface was in the previous view, in the same pixel coordinates the camera generates rays for.
+    fsv3f offset = position - _historyCameraPosition;
+    fsr32 s = fs_vdot(_historyRayBasis[0], offset);
+    if (s <= 0.f) {
+        return;
+    }
+    fsr32 historyX = fs_vdot(_historyRayBasis[1], offset) / s;
+    fsr32 historyY = fs_vdot(_historyRayBasis[2], offset) / s;
+    fsr32 expectedDepth = fs_vlength(offset);
+    
+    // NOTE(christian): Bilinear over the four nearest history pixels, dropping any that saw a different object or a surface
+    // at a different depth (disocclusion) and renormalizing over the rest.
+    fsi32 x0 = (fsi32)floorf(historyX);
+    fsi32 y0 = (fsi32)floorf(historyY);
+    fsr32 fx = historyX - x0;
+    fsr32 fy = historyY - y0;
+    fsv3f color = {};
+    fsr32 sampleCount = 0.f;
+    fsr32 moments = 0.f;
+    fsr32 totalWeight = 0.f;
+    for (fsi32 tap = 0; tap < 4; ++tap) {
+        fsi32 tapX = x0 + (tap & 1);
+        fsi32 tapY = y0 + (tap >> 1);
+        if (tapX < 0 || tapY < 0 || tapX >= width || tapY >= height) {
+            continue;
+        }
+        
+        fsu32 tapIndex = tapX + tapY * width;
+        const Surface& historySurface = _historySurfaces[tapIndex];
+        const fsv4f& history = _historyData[tapIndex];
+        if (historySurface.objectIndex != surface.objectIndex || history.a <= 0.f ||
+            fabsf(historySurface.depth - expectedDepth) > _settings.reprojectionDepthTolerance * expectedDepth) {
+            continue;
+        }
+        
+        fsr32 weight = ((tap & 1) ? fx : 1.f - fx) * ((tap >> 1) ? fy : 1.f - fy);
+        color += history.xyz * (weight / history.a);
+        sampleCount += history.a * weight;
+        moments += _historyMoments[tapIndex] * (weight / history.a);
+        totalWeight += weight;
+    }
+    
+    if (totalWeight < 0.001f) {
+        return;
+    }
+    
+    // Cap how much the history counts for, so that new samples keep replacing stale or resampled ones while moving.
+    fsr32 inverseWeight = 1.f / totalWeight;
+    sampleCount = fsMin(sampleCount * inverseWeight, _settings.reprojectionMaxHistory);
+    color *= inverseWeight * sampleCount;
+    _accumulationData[pixelIndex] = {color.r, color.g, color.b, sampleCount};
+    _luminanceMoments[pixelIndex] = moments * inverseWeight * sampleCount;
+}
+
+void
+mnRenderer::finishTile(fsu32 tileIndex, fsu32 activePixels, bool adaptive) {
+    _tileActivePixels[tileIndex] = activePixels;
+    _tileConverged[tileIndex] = (adaptive && activePixels == 0);
+    _tileChangeFrames[tileIndex] = _resolveFrame;
+}
+
+void
+mnRenderer::resolveImage() {
+    // NOTE(christian): Only tiles that took samples since the target was last resolved are resolved, once per frame however
+    // many passes it had. A new tone mapper changes every pixel, and a new target has none of them yet; a target that isn't
+    // one of the last few takes the place of the one that went longest without a resolve.
+    if (_settings.toneMapper != _resolvedToneMapper) {
+        _resolvedToneMapper = _settings.toneMapper;
+        fs_memclear(_resolvedTargets, sizeof(_resolvedTargets));
+    }
+    
+    ResolvedTarget *resolved = nullptr;
+    ResolvedTarget *oldest = &_resolvedTargets[0];
+    for (ResolvedTarget& candidate : _resolvedTargets) {
+        if (candidate.frame > 0 && candidate.target.pixels == _resolveTarget.pixels &&
+            candidate.target.stride == _resolveTarget.stride && candidate.target.format == _resolveTarget.format) {
+            resolved = &candidate;
+            break;
+        }
+        if (candidate.frame < oldest->frame) {
+            oldest = &candidate;
+        }
+    }
+    fsu32 lastResolvedFrame = (resolved ? resolved->frame : 0);
+    if (!resolved) {
+        resolved = oldest;
+        resolved->target = _resolveTarget;
+    }
+    resolved->frame = _resolveFrame;
+    
+    _activeTiles.clear();
+    for (fsu32 tileIndex = 0; tileIndex < _tiles.size(); ++tileIndex) {
+        if (_tileChangeFrames[tileIndex] > lastResolvedFrame) {
+            _activeTiles.push_back(tileIndex);
+        }
+    }
+    ++_resolveFrame;
+    
+    _threadPool.run((fsu32)_activeTiles.size(), [this](fsu32 jobIndex, fsu32) {
+        resolveTile(_activeTiles[jobIndex]);
+    });
+}
+
+void
+mnRenderer::resolveTile(fsu32 tileIndex) {
+    const mnTile& tile = _tiles[tileIndex];
+    fsr32 red[kTileSize], green[kTileSize], blue[kTileSize], sampleCount[kTileSize];
+    fsu32 count = tile.x1 - tile.x0;
+    for (fsu32 y = tile.y0; y < tile.y1; ++y) {
+        fsu32 rowIndex = tile.x0 + y * _image->width;
+        
+        // Gather the row into separate channels for the kernel, as sums and counts when the format has them.
+        switch (_accumulationFormat) {
+            case AccumulationFormat::rgba32f:
+                for (fsu32 i = 0; i < count; ++i) {
+                    const fsv4f& sum = _accumulationData[rowIndex + i];
+                    red[i] = sum.r;
+                    green[i] = sum.g;
+                    blue[i] = sum.b;
+                    sampleCount[i] = sum.a;
+                }
+                break;
+            case AccumulationFormat::rgb32f:
+                for (fsu32 i = 0; i < count; ++i) {
+                    const fsr32 *sum = _accumulationRGB + (rowIndex + i) * 3;
+                    red[i] = sum[0];
+                    green[i] = sum[1];
+                    blue[i] = sum[2];
+                    sampleCount[i] = _uniformSampleCount;
+                }
+                break;
+            case AccumulationFormat::rgba16f:
+                for (fsu32 i = 0; i < count; ++i) {
+                    fsr32 mean[4];
+                    fs_half4_to_float4(_accumulationHalf + (rowIndex + i) * 4, mean);
+                    red[i] = mean[0];
+                    green[i] = mean[1];
+                    blue[i] = mean[2];
+                    sampleCount[i] = 1.f; // Already a mean
+                }
+                break;
+        }
+        
+        fsu32 *pixels = (fsu32 *)(_resolveTarget.pixels + y * _resolveTarget.stride) + tile.x0;
+        mn_resolve_pixels(red, green, blue, sampleCount, count, _settings.toneMapper, _resolveTarget.format, pixels);
+    }
 }
 
 void
@@ -110,83 +976,460 @@ mnRenderer::resize(fsi16 width, fsi16 height) {
         _image = new mnImage(width, height);
     }
     
-    delete [] _accumulationData;
-    _accumulationData = new fsv4f[width * height];
+    allocateAccumulation(_accumulationFormat);
+    _luminanceMoments.resize(width * height);
+    _pixelConverged.resize(width * height);
+    
+    mn_make_tiles(width, height, kTileSize, _tiles);
+    _tileConverged.resize(_tiles.size());
+    _tileActivePixels.resize(_tiles.size());
+    _tileChangeFrames.assign(_tiles.size(), _resolveFrame);
+    fs_memclear(_resolvedTargets, sizeof(_resolvedTargets));
+    _primaryHitsValid = false;
+    
+    // History is reallocated at the new size by the next render that needs it.
+    delete [] _historyData;
+    _historyData = nullptr;
+    _surfaces.clear();
+    _historyValid = false;
     
-    _imageHorizontalIter.resize(width);
-    _imageVerticalIter.resize(height);
-    for (fsu32 i = 0; i < width; ++i) {
-        _imageHorizontalIter[i] = i;
+    if (_settings.executionMode == ExecutionMode::wavefront) {
+        _pathQueues[0].reserve(width * height);
+        _pathQueues[1].reserve(width * height);
+        _pathRadiance.resize(width * height);
     }
-    for (fsu32 i = 0; i < height; ++i) {
-        _imageVerticalIter[i] = i;
+    
+    // The new accumulation buffer holds nothing yet.
+    _frameIndex = 1;
+}
+
+void
+mnRenderer::cameraChanged() {
+    resetFrameIndex();
+    _cameraMoving = true;
+    _reprojectPending = (_settings.temporalReprojection && _settings.accumulate);
+}
+
+void
+mnRenderer::resolveRadiance(fsr32 *rgb) const {
+    if (!_image) {
+        return;
+    }
+    
+    fsu32 pixelCount = _image->width * _image->height;
+    for (fsu32 i = 0; i < pixelCount; ++i) {
+        fsv3f mean = getPixelMean(i);
+        rgb[i * 3 + 0] = mean.r;
+        rgb[i * 3 + 1] = mean.g;
+        rgb[i * 3 + 2] = mean.b;
+    }
+}
+
+fsu32
+mnRenderer::getConvergedPixelCount() const {
+    // NOTE(christian): Nothing has converged after a reset, whatever the pass before it found.
+    return (_image && _frameIndex > 1 ? _image->width * _image->height - _activePixelCount : 0);
+}
+
+bool
+mnRenderer::isPixelConverged(fsu32 pixelIndex) const {
+    const fsv4f& sum = _accumulationData[pixelIndex];
+    fsr32 n = sum.a;
+    if (n < (fsr32)fsMax(_settings.adaptiveMinSamples, 2u)) {
+        return false;
     }
+    
+    // NOTE(christian): Standard error of the mean luminance, relative to the mean. The small floor keeps black pixels (zero
+    // variance) converging, while dark-but-noisy ones still need a meaningful absolute error to stop.
+    fsr32 mean = luminance(sum) / n;
+    fsr32 variance = fsMax(0.f, _luminanceMoments[pixelIndex] / n - mean * mean) * n / (n - 1.f);
+    fsr32 standardError = sqrtf(variance / n);
+    return standardError <= _settings.adaptiveThreshold * (mean + 0.01f);
+}
+
+void
+mnRenderer::syncScene(const mnScene& scene) {
+    if (&scene == _bvhScene && scene.revision == _bvhSceneRevision) {
+        return;
+    }
+    
+    bool rebuild = (&scene != _bvhScene || _settings.bvhUpdateMode == mnBVH::UpdateMode::rebuild);
+    if (rebuild || scene.spheres.size() != _bvh.primitiveIndices.size()) {
+        _bvh.build(scene);
+    } else {
+        _bvh.refit(scene);
+    }
+    _sphereSoA.build(scene, _bvh.primitiveIndices);
+    
+    // Meshes follow the same rules, each on its own: a mesh whose triangle count changed is rebuilt, and the rest refit.
+    fsu32 meshCount = (fsu32)scene.meshes.size();
+    fsu32 builtMeshCount = (fsu32)fsMin(_meshBVHs.size(), (size_t)meshCount);
+    _meshBVHs.resize(meshCount);
+    _meshTriangleBase.resize(meshCount + 1);
+    _meshTriangleBase[0] = 0;
+    for (fsu32 m = 0; m < meshCount; ++m) {
+        const mnMesh& mesh = scene.meshes[m];
+        mnBVH& meshBVH = _meshBVHs[m];
+        if (rebuild || m >= builtMeshCount || mesh.getTriangleCount() != meshBVH.primitiveIndices.size()) {
+            meshBVH.build(mesh);
+        } else {
+            meshBVH.refit(mesh);
+        }
+        _meshTriangleBase[m + 1] = _meshTriangleBase[m] + mesh.getTriangleCount();
+    }
+    
+    _triangleSoA.reset(_meshTriangleBase[meshCount]);
+    for (fsu32 m = 0; m < meshCount; ++m) {
+        fsi32 objectBase = (fsi32)(scene.spheres.size() + _meshTriangleBase[m]);
+        _triangleSoA.build(scene.meshes[m], _meshBVHs[m].primitiveIndices, _meshTriangleBase[m], objectBase);
+    }
+    
+    _emissiveSpheres.clear();
+    for (fsu32 i = 0; i < scene.spheres.size(); ++i) {
+        if (isEmissive(scene.materials[scene.spheres[i].materialIndex])) {
+            _emissiveSpheres.push_back(i);
+        }
+    }
+    
+    _bvhScene = &scene;
+    _bvhSceneRevision = scene.revision;
+    _primaryHitsValid = false;
+    _historyValid = false;
 }
 
 fsv4f
-mnRenderer::perPixel(fsu32 x, fsu32 y) {
+mnRenderer::perPixel(fsu32 x, fsu32 y, fsu32 sampleIndex, const HitPayload *primaryHit, mnRenderStats& stats) {
     mnRay ray;
     ray.origin = _activeCamera->getPosition();
-    ray.direction = _activeCamera->getRayDirections()[x + y * _image->width];
+    ray.direction = (_rayDirectionTable ? _rayDirectionTable[x + y * _image->width] : _activeCamera->getRayDirection(x, y));
     
     fsv3f light = {};
     fsv3f contribution = {1.f, 1.f, 1.f};
     
-    fsu32 seed = x + y * _image->width;
-    seed *= _frameIndex;
+    // NOTE(christian): Sample indices here count from 1, but the sampler's sequences are best-distributed over their first
+    // 2^n samples counting from 0.
+    mnSamplerState samples = {x + y * _image->width, sampleIndex - 1, 0};
+    
+    bool sampleLights = (_settings.nextEventEstimation && !_emissiveSpheres.empty());
+    fsr32 bsdfPdf = 0.f;
     
-    int bounces = 5;
-    for (int i = 0; i < bounces; ++i) {
-        seed += i;
-        mnRenderer::HitPayload payload = traceRay(ray);
+    fsu32 bounces = _settings.maxBounces;
+    for (fsu32 i = 0; i < bounces; ++i) {
+        samples.dimension = i * kDimensionsPerBounce;
+        mnRenderer::HitPayload payload;
+        if (i == 0 && primaryHit) {
+            payload = *primaryHit;
+        } else {
+            payload = traceRay(ray, i, stats);
+        }
         if (payload.hitDistance < 0.f) {
-            fsv3f skyColor = {0.6f, 0.7f, 0.9f};
-//            light += fs_vhadamard(skyColor, contribution);
+            mnStat(stats.pathsEscaped++);
             break;
         }
         
-        const mnSphere& sphere = _activeScene->spheres[payload.objectIndex];
-        const mnMaterial& material = _activeScene->materials[sphere.materialIndex];
+        const mnMaterial& material = _activeScene->materials[payload.materialIndex];
         
-        contribution = fs_vhadamard(contribution, material.albedo);
-        light += material.getEmission();
+        light += fs_vhadamard(emittedLight(ray, payload, material, i, bsdfPdf), contribution);
+        
+        mnBSDF bsdf(material, payload.worldNormal, -ray.direction);
+        if (sampleLights) {
+            mnRay shadowRay;
+            fsr32 shadowDistance;
+            fsv3f directLight;
+            if (sampleDirectLight(payload, bsdf, samples, shadowRay, shadowDistance, directLight) &&
+                !traceShadowRay(shadowRay, shadowDistance, stats)) {
+                light += fs_vhadamard(directLight, contribution);
+            }
+        }
         
-        ray.origin = payload.worldPosition + payload.worldNormal * 0.0001f;
-        ray.direction = fs_vnormalize(payload.worldNormal + randomInUnitSphere(seed));
+        if (!scatter(payload, bsdf, i, samples, contribution, ray, bsdfPdf, stats)) {
+            break;
+        }
+        
+        mnStat(stats.pathsTerminatedByDepth += (i == bounces - 1));
     }
     
     return {light.r, light.g, light.b, 1.f};
 }
 
-mnRenderer::HitPayload
-mnRenderer::traceRay(const mnRay& ray) {
-    int closestSphere = -1;
-    fsr32 hitDistance = FLT_MAX;
-    for (size_t i = 0; i < _activeScene->spheres.size(); ++i) {
-        const mnSphere& sphere = _activeScene->spheres[i];
-        fsv3f origin = ray.origin - sphere.position;
-        
-        fsr32 a = fs_vdot(ray.direction, ray.direction);
-        fsr32 b = 2.f * fs_vdot(origin, ray.direction);
-        fsr32 c = fs_vdot(origin, origin) - (sphere.radius * sphere.radius);
-        
-        fsr32 discriminant = (b * b) - (4.f * a * c);
-        if (discriminant < 0.f) {
-            continue;
-        }
-        
-        fsr32 closestT = (-b - sqrtf(discriminant)) / (2.f * a);
-        if (closestT > 0.f && closestT < hitDistance) {
-            hitDistance = closestT;
-            closestSphere = (int)i;
+fsv3f
+mnRenderer::emittedLight(const mnRay& ray, const HitPayload& payload, const mnMaterial& material, fsu32 depth, fsr32 bsdfPdf) const {
+    if (!isEmissive(material)) {
+        return {};
+    }
+    
+    // NOTE(christian): When lights are also sampled directly, a bounce that happens to hit one is only one of two ways
+    // this light could have been found, so it's weighted against the light-sampling strategy. Only spheres are sampled as
+    // lights, so emissive meshes are found by bounces alone.
+    fsr32 misWeight = 1.f;
+    if (_settings.nextEventEstimation && depth > 0 && payload.objectIndex < (fsi32)_activeScene->spheres.size()) {
+        misWeight = powerHeuristic(bsdfPdf, directLightPdf(ray.origin, payload.objectIndex));
+    }
+    return material.getEmission() * misWeight;
+}
+
+bool
+mnRenderer::scatter(const HitPayload& payload, const mnBSDF& bsdf, fsu32 depth, const mnSamplerState& samples,
+                    fsv3f& contribution, mnRay& ray, fsr32& bsdfPdf, mnRenderStats& stats) const {
+    mnBSDFSample bsdfSample;
+    if (!bsdf.sample(_sampler.get(samples, kLobeDimension), _sampler.get(samples, kScatterDimension),
+                     _sampler.get(samples, kScatterDimension + 1), bsdfSample)) {
+        return false;
+    }
+    contribution = fs_vhadamard(contribution, bsdfSample.weight);
+    
+    if (_settings.russianRoulette && depth + 1 >= _settings.rouletteMinBounces && depth + 1 < _settings.maxBounces) {
+        // Survive in proportion to the remaining throughput, and boost survivors so the estimate stays unbiased.
+        fsr32 survival = fsMax(contribution.r, fsMax(contribution.g, contribution.b));
+        survival = fsClamp(survival, _settings.rouletteMinSurvival, _settings.rouletteMaxSurvival);
+        if (_sampler.get(samples, kRouletteDimension) >= survival) {
+            mnStat(stats.pathsTerminatedByRoulette++);
+            return false;
         }
+        contribution *= 1.f / survival;
     }
     
-    if (closestSphere < 0) {
+    ray.origin = payload.worldPosition + payload.worldNormal * 0.0001f;
+    ray.direction = bsdfSample.direction;
+    bsdfPdf = bsdfSample.pdf;
+    return true;
+}
+
+mnRenderer::HitPayload
+mnRenderer::traceRay(const mnRay& ray, fsu32 depth, mnRenderStats& stats) {
+    stats.rayCount++;
+    mnStat(stats.raysPerDepth[fsMin(depth, (fsu32)MN_STATS_MAX_DEPTH - 1)]++);
+    
+    fsr32 hitDistance;
+    fsi32 objectIndex;
+    if (!intersectScene(ray, hitDistance, objectIndex, stats)) {
         return miss(ray);
     }
     
-    return closestHit(ray, hitDistance, closestSphere);
+    return closestHit(ray, hitDistance, objectIndex);
+}
+
+void
+mnRenderer::getPrimaryRayDirections(fsu32 x, fsu32 y, fsu32 count, fsr32 *directionX, fsr32 *directionY, fsr32 *directionZ) const {
+    if (!_rayDirectionTable) {
+        _activeCamera->generateRayDirections(x, y, count, directionX, directionY, directionZ);
+        return;
+    }
+    
+    const fsv3f *directions = _rayDirectionTable + x + y * _image->width;
+    for (fsu32 i = 0; i < count; ++i) {
+        directionX[i] = directions[i].x;
+        directionY[i] = directions[i].y;
+        directionZ[i] = directions[i].z;
+    }
+}
+
+void
+mnRenderer::tracePacket(mnRayPacket& packet, mnRenderStats& stats) {
+    packet.finalize();
+    stats.rayCount += packet.count;
+    mnStat(stats.raysPerDepth[0] += packet.count);
+    
+    if (_settings.useBVH) {
+        _bvh.traversePacket(packet, [&](fsu32 first, fsu32 count) {
+            fsu32 testedCount = mn_intersect_spheres_packet(_sphereSoA, first, count, packet);
+            mnStat(stats.sphereTests += (fsu64)testedCount * packet.count);
+        });
+    } else {
+        fsu32 testedCount = mn_intersect_spheres_packet(_sphereSoA, 0, _sphereSoA.count, packet);
+        mnStat(stats.sphereTests += (fsu64)testedCount * packet.count);
+    }
+    
+    if (_settings.useBVH) {
+        for (fsu32 m = 0; m < _meshBVHs.size(); ++m) {
+            fsu32 firstLane = _meshTriangleBase[m];
+            _meshBVHs[m].traversePacket(packet, [&](fsu32 first, fsu32 count) {
+                fsu32 testedCount = mn_intersect_triangles_packet(_triangleSoA, firstLane + first, count, packet);
+                mnStat(stats.triangleTests += (fsu64)testedCount * packet.count);
+            });
+        }
+    } else if (_triangleSoA.count > 0) {
+        fsu32 testedCount = mn_intersect_triangles_packet(_triangleSoA, 0, _triangleSoA.count, packet);
+        mnStat(stats.triangleTests += (fsu64)testedCount * packet.count);
+    }
+    
+#if MN_STATS
+    for (fsu32 i = 0; i < packet.count; ++i) {
+        stats.hits += (packet.hitObject[i] >= 0);
+        stats.misses += (packet.hitObject[i] < 0);
+    }
+#endif
+}
+
+mnRenderer::HitPayload
+mnRenderer::getPacketHit(const mnRayPacket& packet, fsu32 index) {
+    if (packet.hitObject[index] < 0) {
+        return miss(packet.getRay(index));
+    }
+    
+    return closestHit(packet.getRay(index), packet.hitDistance[index], packet.hitObject[index]);
+}
+
+bool
+mnRenderer::intersectScene(const mnRay& ray, fsr32& hitDistance, fsi32& objectIndex, mnRenderStats& stats) {
+    hitDistance = FLT_MAX;
+    fsu32 closestLane = 0;
+    bool hit = false;
+    
+    if (_settings.useBVH) {
+        _bvh.traverse(ray, hitDistance, [&](fsu32 first, fsu32 count, fsr32& closestT) {
+            mnStat(stats.sphereTests += count);
+            hit |= mn_intersect_spheres(_sphereSoA, first, count, ray, closestT, closestLane);
+            return false;
+        });
+    } else {
+        mnStat(stats.sphereTests += _sphereSoA.count);
+        hit = mn_intersect_spheres(_sphereSoA, 0, _sphereSoA.count, ray, hitDistance, closestLane);
+    }
+    
+    objectIndex = (hit ? _sphereSoA.sphereIndex[closestLane] : -1);
+    fsu32 triangleLane;
+    if (intersectMeshes(ray, hitDistance, triangleLane, stats)) {
+        objectIndex = _triangleSoA.objectIndex[triangleLane];
+    }
+    if (objectIndex < 0) {
+        mnStat(stats.misses++);
+        return false;
+    }
+    
+    mnStat(stats.hits++);
+    return true;
+}
+
+bool
+mnRenderer::intersectMeshes(const mnRay& ray, fsr32& hitDistance, fsu32& lane, mnRenderStats& stats) {
+    if (!_settings.useBVH) {
+        mnStat(stats.triangleTests += _triangleSoA.count);
+        return (_triangleSoA.count > 0 && mn_intersect_triangles(_triangleSoA, 0, _triangleSoA.count, ray, hitDistance, lane));
+    }
+    
+    // NOTE(christian): There's no hierarchy over the meshes themselves; each mesh's root is culled against the closest hit
+    // found so far, which is cheap for the handful of meshes a scene has.
+    bool hit = false;
+    for (fsu32 m = 0; m < _meshBVHs.size(); ++m) {
+        fsu32 firstLane = _meshTriangleBase[m];
+        _meshBVHs[m].traverse(ray, hitDistance, [&](fsu32 first, fsu32 count, fsr32& closestT) {
+            mnStat(stats.triangleTests += count);
+            hit |= mn_intersect_triangles(_triangleSoA, firstLane + first, count, ray, closestT, lane);
+            return false;
+        });
+    }
+    return hit;
+}
+
+bool
+mnRenderer::traceShadowRay(const mnRay& ray, fsr32 maxDistance, mnRenderStats& stats) {
+    stats.rayCount++;
+    mnStat(stats.shadowRays++);
+    
+    bool occluded = false;
+    if (_settings.useBVH) {
+        fsr32 hitDistance = maxDistance;
+        _bvh.traverse(ray, hitDistance, [&](fsu32 first, fsu32 count, fsr32& closestT) {
+            mnStat(stats.sphereTests += count);
+            occluded = mn_occluded_spheres(_sphereSoA, first, count, ray, maxDistance);
+            return occluded;
+        });
+    } else {
+        mnStat(stats.sphereTests += _sphereSoA.count);
+        occluded = mn_occluded_spheres(_sphereSoA, 0, _sphereSoA.count, ray, maxDistance);
+    }
+    occluded = (occluded || occludedByMeshes(ray, maxDistance, stats));
+    
+    mnStat(stats.shadowRaysOccluded += occluded);
+    return occluded;
+}
+
+bool
+mnRenderer::occludedByMeshes(const mnRay& ray, fsr32 maxDistance, mnRenderStats& stats) {
+    if (!_settings.useBVH) {
+        mnStat(stats.triangleTests += _triangleSoA.count);
+        return (_triangleSoA.count > 0 && mn_occluded_triangles(_triangleSoA, 0, _triangleSoA.count, ray, maxDistance));
+    }
+    
+    bool occluded = false;
+    for (fsu32 m = 0; m < _meshBVHs.size() && !occluded; ++m) {
+        fsu32 firstLane = _meshTriangleBase[m];
+        fsr32 hitDistance = maxDistance;
+        _meshBVHs[m].traverse(ray, hitDistance, [&](fsu32 first, fsu32 count, fsr32& closestT) {
+            mnStat(stats.triangleTests += count);
+            occluded = mn_occluded_triangles(_triangleSoA, firstLane + first, count, ray, maxDistance);
+            return occluded;
+        });
+    }
+    return occluded;
+}
+
+bool
+mnRenderer::sampleDirectLight(const HitPayload& payload, const mnBSDF& bsdf, const mnSamplerState& samples,
+                              mnRay& shadowRay, fsr32& shadowDistance, fsv3f& directLight) const {
+    fsu32 lightCount = (fsu32)_emissiveSpheres.size();
+    fsu32 lightIndex = _emissiveSpheres[fsMin((fsu32)(_sampler.get(samples, kLightChoiceDimension) * lightCount), lightCount - 1)];
+    fsr32 u1 = _sampler.get(samples, kLightDimension);
+    fsr32 u2 = _sampler.get(samples, kLightDimension + 1);
+    
+    // NOTE(christian): A convex sphere can't light itself.
+    if ((fsi32)lightIndex == payload.objectIndex) {
+        return false;
+    }
+    
+    const mnSphere& lightSphere = _activeScene->spheres[lightIndex];
+    fsv3f origin = payload.worldPosition + payload.worldNormal * 0.0001f;
+    fsv3f toCenter = lightSphere.position - origin;
+    fsr32 distanceSq = fs_vdot(toCenter, toCenter);
+    fsr32 radiusSq = lightSphere.radius * lightSphere.radius;
+    fsr32 oneMinusCosMax = coneOneMinusCos(radiusSq, distanceSq);
+    if (oneMinusCosMax <= 0.f) {
+        return false;
+    }
+    
+    // Uniformly sample a direction inside the cone the light subtends.
+    fsr32 cosTheta = 1.f - u1 * oneMinusCosMax;
+    fsr32 sinTheta = sqrtf(fsMax(0.f, 1.f - cosTheta * cosTheta));
+    fsr32 phi = fsTau32 * u2;
+    fsv3f w = toCenter * (1.f / sqrtf(distanceSq));
+    fsv3f tangent, bitangent;
+    mn_make_basis(w, tangent, bitangent);
+    fsv3f direction = tangent * (cosf(phi) * sinTheta) + bitangent * (sinf(phi) * sinTheta) + w * cosTheta;
+    
+    fsr32 bsdfPdf;
+    fsv3f bsdfValue = bsdf.evaluate(direction, bsdfPdf);
+    if (bsdfPdf <= 0.f) {
+        return false;
+    }
+    
+    // Distance to the near side of the light along the sampled direction.
+    fsr32 b = fs_vdot(toCenter, direction);
+    fsr32 lightDistance = b - sqrtf(fsMax(0.f, b * b - distanceSq + radiusSq));
+    
+    shadowRay.origin = origin;
+    shadowRay.direction = direction;
+    shadowDistance = lightDistance * 0.999f;
+    
+    fsr32 lightPdf = 1.f / (fsTau32 * oneMinusCosMax * lightCount);
+    fsr32 misWeight = powerHeuristic(lightPdf, bsdfPdf);
+    
+    const mnMaterial& lightMaterial = _activeScene->materials[lightSphere.materialIndex];
+    
+    directLight = fs_vhadamard(lightMaterial.getEmission(), bsdfValue) * (misWeight / lightPdf);
+    return true;
+}
+
+fsr32
+mnRenderer::directLightPdf(const fsv3f& position, fsi32 sphereIndex) const {
+    const mnSphere& lightSphere = _activeScene->spheres[sphereIndex];
+    fsv3f toCenter = lightSphere.position - position;
+    fsr32 oneMinusCosMax = coneOneMinusCos(lightSphere.radius * lightSphere.radius, fs_vdot(toCenter, toCenter));
+    if (oneMinusCosMax <= 0.f) {
+        return 0.f;
+    }
+    
+    return 1.f / (fsTau32 * oneMinusCosMax * _emissiveSpheres.size());
 }
 
 mnRenderer::HitPayload
@@ -195,11 +1438,31 @@ mnRenderer::closestHit(const mnRay& ray, fsr32 hitDistance, fsi32 objectIndex) {
     payload.hitDistance = hitDistance;
     payload.objectIndex = objectIndex;
     
+    fsu32 sphereCount = (fsu32)_activeScene->spheres.size();
+    if ((fsu32)objectIndex >= sphereCount) {
+        // Find the mesh from the triangle's index among all mesh triangles.
+        fsu32 triangleIndex = (fsu32)objectIndex - sphereCount;
+        fsu32 meshIndex = (fsu32)(std::upper_bound(_meshTriangleBase.begin(), _meshTriangleBase.end(), triangleIndex) -
+                                  _meshTriangleBase.begin()) - 1;
+        const mnMesh& mesh = _activeScene->meshes[meshIndex];
+        const fsu32 *indices = &mesh.indices[(triangleIndex - _meshTriangleBase[meshIndex]) * 3];
+        
+        // NOTE(christian): Meshes are shaded flat, with the normal turned to face the ray so that both sides of a triangle
+        // shade the same.
+        fsv3f v0 = mesh.getVertex(indices[0]);
+        fsv3f normal = fs_vnormalize(fs_vcross(mesh.getVertex(indices[1]) - v0, mesh.getVertex(indices[2]) - v0));
+        payload.worldPosition = ray.origin + ray.direction * hitDistance;
+        payload.worldNormal = (fs_vdot(normal, ray.direction) > 0.f ? -normal : normal);
+        payload.materialIndex = mesh.materialIndex;
+        return payload;
+    }
+    
     const mnSphere& closestSphere = _activeScene->spheres[objectIndex];
     fsv3f origin = ray.origin - closestSphere.position;
     payload.worldPosition = origin + ray.direction * hitDistance;
     payload.worldNormal = fs_vnormalize(payload.worldPosition);
     payload.worldPosition += closestSphere.position;
+    payload.materialIndex = closestSphere.materialIndex;
     
     return payload;
 }
@@ -208,5 +1471,7 @@ mnRenderer::HitPayload
 mnRenderer::miss(const mnRay& ray) {
     mnRenderer::HitPayload payload;
     payload.hitDistance = -1.f;
+    payload.objectIndex = -1;
+    payload.materialIndex = -1;
     return payload;
 }
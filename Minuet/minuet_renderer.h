@@ -8,9 +8,18 @@
 
 #pragma once
 #include "minuet_platform.h"
+#include "minuet_bsdf.h"
+#include "minuet_bvh.h"
 #include "minuet_camera.h"
 #include "minuet_ray.h"
+#include "minuet_resolve.h"
+#include "minuet_sampler.h"
 #include "minuet_scene.h"
+#include "minuet_sphere_soa.h"
+#include "minuet_stats.h"
+#include "minuet_thread_pool.h"
+#include "minuet_triangle_soa.h"
+#include "minuet_wavefront.h"
 
 
 #pragma mark - mnImage
@@ -32,16 +41,101 @@ public:
 
 struct mnRenderer {
     
+    enum struct ExecutionMode {
+        megakernel, // Each job traces whole paths for the pixels of one tile
+        wavefront,  // Each bounce is a separate stage over queues of every in-flight path
+    };
+    
+    enum struct AccumulationFormat {
+        rgba32f,    // Float sum and sample count per pixel (16 bytes)
+        rgb32f,     // Float sum per pixel (12 bytes); every pixel holds the same number of samples
+        rgba16f,    // Half float running mean per pixel (8 bytes), good to about three significant digits. Past
+                    // 1024 samples it becomes a moving average over about that many, and stops converging any further.
+    };
+    
     struct Settings {
+        ExecutionMode executionMode = ExecutionMode::megakernel;
+        mnSamplerType samplerType = mnSamplerType::sobol;
+        mnToneMapper toneMapper = mnToneMapper::clamp;
         bool accumulate = true;
+        // Adaptive sampling and temporal reprojection need each pixel's own sample count, so they always use rgba32f.
+        AccumulationFormat accumulationFormat = AccumulationFormat::rgba32f;
+        bool useBVH = true;
+        bool primaryRayPackets = true; // Trace primary rays in 8x8 packets; secondary bounces are always traced one at a time
+        bool cachePrimaryHits = true; // Reuse the first frame's primary hits until the camera or scene changes
+        bool precomputedRayDirections = false; // Read primary ray directions from the camera's per-pixel table instead of generating them
+        mnBVH::UpdateMode bvhUpdateMode = mnBVH::UpdateMode::refit;
+        fsu32 threadCount = 0; // 0 = one worker per hardware thread
+        fsu32 samplesPerPixel = 1; // Paths traced per pixel in each pass
+        fsr32 frameTimeBudget = 0.f; // Milliseconds of each call to render to fill with extra passes; 0 = a single pass
+        fsu32 maxBounces = 5;
+        bool russianRoulette = true;
+        fsu32 rouletteMinBounces = 2; // Bounces every path takes before it can be terminated by roulette
+        fsr32 rouletteMinSurvival = 0.05f;
+        fsr32 rouletteMaxSurvival = 0.95f;
+        bool nextEventEstimation = true; // Sample emissive spheres directly at every bounce, combined with MIS
+        bool adaptiveSampling = false; // Stop sampling converged pixels and spend their budget on noisy ones (accumulation only)
+        fsr32 adaptiveThreshold = 0.02f; // Relative standard error of a pixel's mean luminance at which it counts as converged
+        fsu32 adaptiveMinSamples = 16;
+        fsu32 adaptiveMaxBoost = 4; // Most samples an unconverged pixel gets per frame, as a multiple of samplesPerPixel
+        bool temporalReprojection = false; // Carry accumulated samples over camera moves instead of starting from scratch
+        fsr32 reprojectionMaxHistory = 8.f; // Most samples' worth of weight that reprojected history keeps
+        fsr32 reprojectionDepthTolerance = 0.05f; // Relative depth change beyond which a history sample is treated as disoccluded
+        bool dynamicResolution = false; // Trace a fraction of the pixels while the camera moves, and upscale them to the image
+        fsr32 dynamicResolutionBudget = 16.f; // Frame time in milliseconds that dynamic resolution aims for
+        fsr32 dynamicResolutionMinScale = 0.25f; // Smallest fraction of the width and height that's traced
+        fsr32 dynamicResolutionDepthTolerance = 0.1f; // Relative depth difference over which upscaling stops blending samples
     };
     
+    static const fsu32 kTileSize = 32;
+    static const fsu32 kPacketSize = 8; // Width and height of the pixel blocks traced as one primary ray packet
+    static const fsu32 kWavefrontChunkSize = 1024; // Paths per job in each wavefront stage
+    static const fsu32 kMaxPassesPerFrame = 256;
+    
+    // Sampler dimensions of each bounce, as offsets from depth * kDimensionsPerBounce. The Sobol and blue noise samplers
+    // stratify dimensions in pairs (0, 1), (2, 3) and so on, so every 2D decision has to start on an even dimension, and
+    // kDimensionsPerBounce has to stay even.
+    static const fsu32 kLightChoiceDimension = 0;
+    static const fsu32 kRouletteDimension = 1;
+    static const fsu32 kLightDimension = 2;      // Two dimensions: the point on the light
+    static const fsu32 kScatterDimension = 4;    // Two dimensions: the bounce direction
+    static const fsu32 kLobeDimension = 6;
+    static const fsu32 kDimensionsPerBounce = 8;
+    /*! @brief Number of resolve targets that are remembered, enough for the render thread's triple buffer. */
+    static const fsu32 kMaxResolvedTargets = 3;
+    
     mnRenderer() = default;
     
     mnImage* render(const mnScene& scene, const mnCamera& camera);
+    /*! @brief Renders like \c render, but resolves the frame straight into \c pixels, which holds the renderer's height in rows
+        of its width in pixels, \c stride bytes apart (a multiple of 4). While the same buffer, or the same few (up to
+        kMaxResolvedTargets) in rotation, are passed each frame, only the tiles that changed since a buffer was last passed
+        are rewritten, so the caller shouldn't write to them in between. */
+    void renderInto(const mnScene& scene, const mnCamera& camera, void *pixels, size_t stride, mnPixelFormat format);
     void resize(fsi16 width, fsi16 height);
     
-    void resetFrameIndex() { _frameIndex = 1; }
+    /*! @brief Starts accumulating from scratch, and drops the cached primary hits. */
+    void resetFrameIndex() { _frameIndex = 1; _primaryHitsValid = false; _reprojectPending = false; }
+    /*! @brief Call whenever the camera moves. Same as \c resetFrameIndex, except that with temporal reprojection on, the next
+        frame starts from the previous accumulation reprojected into the new view wherever it's still visible. */
+    void cameraChanged();
+    /*! @brief While set, every frame renders as if the camera had just moved, not only the first one after \c cameraChanged.
+        For callers that keep rendering between camera updates, and only find out later that the camera stopped. */
+    void setCameraMoving(bool moving) { _cameraMoving = _cameraMovingHeld = moving; }
+    
+    /*! @brief Writes the unclamped, averaged radiance of every pixel as width * height RGB triplets into \c rgb.
+        Rows are stored in the same order as the image's pixel data. */
+    void resolveRadiance(fsr32 *rgb) const;
+    fsu32 getAccumulatedSampleCount() const { return _accumulatedSamples; }
+    /*! @brief Sample passes taken by the last call to render; more than one only with a frame time budget. */
+    fsu32 getFramePassCount() const { return _framePassCount; }
+    /*! @brief Number of pixels that have reached the adaptive sampling threshold since the last reset. */
+    fsu32 getConvergedPixelCount() const;
+    
+    /*! @brief Counters from the last call to render, merged across workers. Only \c rayCount is gathered when MN_STATS is 0. */
+    const mnRenderStats& getStats() const { return _stats; }
+    /*! @brief Fraction of the width and height traced by the last call to render; below 1 only for dynamic resolution. */
+    fsr32 getResolutionScale() const { return 1.f / _resolutionStride; }
     
     Settings& getSettings() { return _settings; }
     
@@ -53,23 +147,183 @@ private:
         fsv3f worldPosition;
         fsv3f worldNormal;
         fsr32 hitDistance;
-        fsi32 objectIndex;
+        fsi32 objectIndex;  // Spheres first, then the triangles of every mesh in order
+        fsi32 materialIndex;
+    };
+    
+    enum struct PrimaryHitCache {
+        none,   // Trace primary rays as usual
+        fill,   // Trace primary rays and store their hits for later frames
+        reuse,  // Start every path from the stored hit
+    };
+    
+    /*! @brief What the primary ray of a pixel hit, kept from frame to frame for reprojection. */
+    struct Surface {
+        fsr32 depth;        // Distance along the primary ray
+        fsi32 objectIndex;  // -1 on a miss
+    };
+    
+    struct WorkerStats {
+        mnRenderStats stats;
+        fsu8 pad_[64]; // Keeps each worker's counters off its neighbours' cache lines.
     };
     
-    fsv4f perPixel(fsu32 x, fsu32 y);
-    HitPayload traceRay(const mnRay& ray);
+    void syncScene(const mnScene& scene);
+    bool isPixelConverged(fsu32 pixelIndex) const;
+    /*! @brief Format the accumulation has to use with the current settings. */
+    AccumulationFormat getAccumulationFormat() const;
+    void allocateAccumulation(AccumulationFormat format);
+    fsr32 getPixelSampleCount(fsu32 pixelIndex) const;
+    fsv3f getPixelMean(fsu32 pixelIndex) const;
+    /*! @brief Adds \c sum, the total of \c sampleCount new samples, to the pixel's accumulation. */
+    void accumulatePixel(fsu32 pixelIndex, const fsv3f& sum, fsr32 sampleCount);
+    /*! @brief Returns true if the pixel still needs samples, and marks it converged once it doesn't. */
+    bool updatePixelConvergence(fsu32 pixelIndex, bool adaptive);
+    void finishTile(fsu32 tileIndex, fsu32 activePixels, bool adaptive);
+    /*! @brief Writes the accumulation of every tile that has taken samples since it was last resolved to the resolve target. */
+    void resolveImage();
+    void resolveTile(fsu32 tileIndex);
+    /*! @brief Replaces the pixel's (empty) accumulation with history from the previous view, if the surface it sees now was
+        also visible there. */
+    void reprojectPixel(fsu32 pixelIndex);
+    
+    void renderFrame(const mnScene& scene, const mnCamera& camera);
+    /*! @brief Renders one pass, then more for as long as the next is predicted to fit in the frame time budget. */
+    void renderFullResolution();
+    /*! @brief Takes a pass of samples of every pixel that needs them into the accumulation. */
+    void renderPass();
+    void renderMegakernel(fsu32 sampleCount, bool adaptive);
+    void renderWavefront(fsu32 sampleCount, bool adaptive);
+    void generatePaths(mnPathQueue& queue, bool adaptive);
+    void shadePaths(fsu32 depth, mnPathQueue& queue, mnPathQueue& nextQueue);
+    /*! @brief Traces every \c stride-th pixel in each direction into the low resolution buffer, without accumulating, then
+        upscales it into the image. */
+    void renderDynamicResolution(fsu32 stride);
+    void upscaleRow(fsu32 y, fsu32 stride);
+    
+    /*! @brief Traces one path through pixel (x, y). If \c primaryHit is given, it's used in place of tracing the primary ray. */
+    fsv4f perPixel(fsu32 x, fsu32 y, fsu32 sampleIndex, const HitPayload *primaryHit, mnRenderStats& stats);
+    HitPayload traceRay(const mnRay& ray, fsu32 depth, mnRenderStats& stats);
+    /*! @brief Directions of \c count consecutive primary rays from pixel (x, y), as SoA components. Each array needs room for
+        \c count rounded up to a multiple of FS_SIMD_WIDTH. */
+    void getPrimaryRayDirections(fsu32 x, fsu32 y, fsu32 count, fsr32 *directionX, fsr32 *directionY, fsr32 *directionZ) const;
+    void tracePacket(mnRayPacket& packet, mnRenderStats& stats);
+    HitPayload getPacketHit(const mnRayPacket& packet, fsu32 index);
+    bool intersectScene(const mnRay& ray, fsr32& hitDistance, fsi32& objectIndex, mnRenderStats& stats);
+    /*! @brief Finds the closest triangle of any mesh nearer than \c hitDistance. On a hit, updates \c hitDistance and sets
+        \c lane to the triangle's lane in the triangle SoA. */
+    bool intersectMeshes(const mnRay& ray, fsr32& hitDistance, fsu32& lane, mnRenderStats& stats);
+    bool traceShadowRay(const mnRay& ray, fsr32 maxDistance, mnRenderStats& stats);
+    bool occludedByMeshes(const mnRay& ray, fsr32 maxDistance, mnRenderStats& stats);
+    
+    /*! @brief Emission seen at \c payload along \c ray, MIS-weighted against light sampling when \c depth > 0. Not yet
+        multiplied by the path throughput. */
+    fsv3f emittedLight(const mnRay& ray, const HitPayload& payload, const mnMaterial& material, fsu32 depth, fsr32 bsdfPdf) const;
+    /*! @brief Picks a point on an emissive sphere as seen from \c payload. Returns false if the sample can't contribute;
+        otherwise \c directLight is the MIS-weighted contribution if the shadow ray turns out to be unoccluded. */
+    bool sampleDirectLight(const HitPayload& payload, const mnBSDF& bsdf, const mnSamplerState& samples, mnRay& shadowRay,
+                           fsr32& shadowDistance, fsv3f& directLight) const;
+    /*! @brief Samples the next bounce from \c bsdf into \c ray, and applies its weight and Russian roulette to
+        \c contribution. Returns false if the path ends, because roulette ended it or the BSDF had no direction to give. */
+    bool scatter(const HitPayload& payload, const mnBSDF& bsdf, fsu32 depth, const mnSamplerState& samples,
+                 fsv3f& contribution, mnRay& ray, fsr32& bsdfPdf, mnRenderStats& stats) const;
+    fsr32 directLightPdf(const fsv3f& position, fsi32 sphereIndex) const;
     HitPayload closestHit(const mnRay& ray, fsr32 hitDistance, fsi32 objectIndex);
     HitPayload miss(const mnRay& ray);
     
 private:
     Settings _settings;
     
-    std::vector<fsu32> _imageHorizontalIter, _imageVerticalIter;
+    mnThreadPool _threadPool;
+    mnSampler _sampler;
+    std::vector<mnTile> _tiles;
+    std::vector<WorkerStats> _workerStats;
+    mnRenderStats _stats = {};
     
     mnImage * _image = nullptr;
+    // Only the buffer for the current format is allocated.
+    AccumulationFormat _accumulationFormat = AccumulationFormat::rgba32f;
     fsv4f * _accumulationData = nullptr;
-    fsu32 _frameIndex = 1;
+    fsr32 * _accumulationRGB = nullptr;
+    fsu16 * _accumulationHalf = nullptr;
+    fsr32 _uniformSampleCount = 0.f; // Samples every pixel holds, for the formats without a per-pixel count
+    fsu32 _frameIndex = 1; // Index of the next sample to accumulate, starting at 1
+    fsu32 _accumulatedSamples = 0;
+    fsu32 _framePassCount = 0;
+    
+    // Adaptive sampling. The accumulation alpha holds each pixel's sample count, and the moments hold its sum of squared luminance.
+    std::vector<fsr32> _luminanceMoments;
+    std::vector<fsu8> _pixelConverged;
+    std::vector<fsu8> _tileConverged;
+    std::vector<fsu32> _tileActivePixels;
+    std::vector<fsu32> _activeTiles;
+    fsu32 _activePixelCount = 0;
+    
+    // Resolve. The target is where resolved pixels go this frame; the image, or the caller's buffer for renderInto. Tiles
+    // are stamped with the frame they last changed in, and the last few targets with the frame they were last resolved in,
+    // so a caller rotating between buffers still only gets the tiles each one is missing.
+    struct ResolveTarget {
+        fsu8 *pixels;
+        size_t stride;
+        mnPixelFormat format;
+    };
+    struct ResolvedTarget {
+        ResolveTarget target;
+        fsu32 frame;    // _resolveFrame when it was last resolved into; 0 for an unused entry
+    };
+    ResolveTarget _resolveTarget = {};
+    ResolvedTarget _resolvedTargets[kMaxResolvedTargets] = {};
+    mnToneMapper _resolvedToneMapper = mnToneMapper::clamp;
+    std::vector<fsu32> _tileChangeFrames; // _resolveFrame when each tile's accumulation last changed
+    fsu32 _resolveFrame = 1;
     
     const mnScene * _activeScene;
     const mnCamera * _activeCamera;
+    const fsv3f * _rayDirectionTable = nullptr; // Camera's precomputed directions, or null to generate them
+    
+    mnBVH _bvh;
+    mnSphereSoA _sphereSoA;
+    const mnScene * _bvhScene = nullptr;
+    fsu32 _bvhSceneRevision = 0;
+    std::vector<fsu32> _emissiveSpheres;
+    
+    // Meshes. Each has its own hierarchy, and its triangles occupy lanes [_meshTriangleBase[m], _meshTriangleBase[m + 1]) of
+    // the triangle SoA in the order of its hierarchy's primitives. Triangles come after the spheres in object indices.
+    std::vector<mnBVH> _meshBVHs;
+    std::vector<fsu32> _meshTriangleBase;
+    mnTriangleSoA _triangleSoA;
+    
+    // Wavefront mode. Paths are read from one queue and their survivors compacted into the other at each bounce.
+    mnPathQueue _pathQueues[2];
+    std::vector<fsv3f> _pathRadiance;
+    
+    // Temporal reprojection. The history buffers hold the accumulation, and what each pixel saw, from before the last
+    // camera move; the surfaces and view of the current accumulation become the history on the next one.
+    fsv4f * _historyData = nullptr;
+    std::vector<fsr32> _historyMoments;
+    std::vector<Surface> _surfaces;
+    std::vector<Surface> _historySurfaces;
+    fsv3f _rayBasis[3];
+    fsv3f _cameraPosition;
+    fsv3f _historyRayBasis[3];
+    fsv3f _historyCameraPosition;
+    fsu32 _sampleIndexBase = 0; // Added to every sample index, so frames after a reprojection don't repeat the history's noise
+    bool _reprojectPending = false;
+    bool _historyValid = false;
+    bool _reprojecting = false;
+    
+    // Primary hits of every pixel, valid while the camera and scene are unchanged since the frame that stored them.
+    std::vector<HitPayload> _primaryHits;
+    PrimaryHitCache _primaryHitCache = PrimaryHitCache::none;
+    bool _primaryHitsValid = false;
+    const mnCamera * _primaryHitCamera = nullptr;
+    
+    // Dynamic resolution. While the camera moves, frames trace a grid of every _resolutionStride-th pixel into the low
+    // resolution buffer (radiance, with the primary hit distance in alpha) and leave the accumulation alone.
+    std::vector<fsv4f> _lowResolutionData;
+    fsr32 _resolutionScale = 0.5f; // Scale the next moving frame aims for, adapted to the budget
+    fsu32 _resolutionStride = 1;
+    fsu32 _movingFrameIndex = 0; // Counts moving frames, so each one takes different sample indices than the last
+    bool _cameraMoving = false;
+    bool _cameraMovingHeld = false; // Set by setCameraMoving, keeps _cameraMoving from clearing after each frame
 };
@@ -0,0 +1,109 @@
+//
+//  minuet_resolve.cpp
+//  Minuet
+//
+//  Created by Christian Floisand on 2026-10-16.
+//
+
+#include "minuet_resolve.h"
+#include "fs_simd.h"
+
+
+static inline fsWide
+toneMap(fsWide x, mnToneMapper toneMapper) {
+    fsWide zero = fs_wide_set1(0.f);
+    fsWide one = fs_wide_set1(1.f);
+    x = fs_wide_max(x, zero);
+    switch (toneMapper) {
+        case mnToneMapper::clamp:
+            break;
+        case mnToneMapper::reinhard:
+            x = x / (x + one);
+            break;
+        case mnToneMapper::aces: {
+            fsWide numerator = x * (x * fs_wide_set1(2.51f) + fs_wide_set1(0.03f));
+            fsWide denominator = x * (x * fs_wide_set1(2.43f) + fs_wide_set1(0.59f)) + fs_wide_set1(0.14f);
+            x = numerator / denominator;
+            break;
+        }
+    }
+    return fs_wide_min(x, one);
+}
+
+/*! @brief sRGB encoding of \c x in [0, 1]. Above the linear segment, x^(1/2.4) is fitted with x^(1/2), x^(1/4) and x^(1/8),
+    which are only square roots; the result is within a quarter of an 8-bit step of the exact curve. */
+static inline fsWide
+encodeSRGB(fsWide x) {
+    fsWide s1 = fs_wide_sqrt(x);
+    fsWide s2 = fs_wide_sqrt(s1);
+    fsWide s3 = fs_wide_sqrt(s2);
+    fsWide curve = s1 * fs_wide_set1(0.662002687f) + s2 * fs_wide_set1(0.684122060f) - s3 * fs_wide_set1(0.323583601f) -
+                   x * fs_wide_set1(0.0225411470f);
+    fsWide linear = x * fs_wide_set1(12.92f);
+    return fs_wide_select(x < fs_wide_set1(0.0031308f), linear, curve);
+}
+
+static inline fsWideInt
+toByte(fsWide x) {
+    return fs_wide_to_int(x * fs_wide_set1(255.f) + fs_wide_set1(0.5f));
+}
+
+/*! @brief Where each channel's byte goes in a pixel's word, for a little-endian load of the pixel. */
+struct PixelShifts {
+    int red, green, blue, alpha;
+};
+
+static inline PixelShifts
+getPixelShifts(mnPixelFormat format) {
+    switch (format) {
+        case mnPixelFormat::rgba32: return {24, 16, 8, 0};
+        case mnPixelFormat::rgba8: return {0, 8, 16, 24};
+        case mnPixelFormat::bgra8: return {16, 8, 0, 24};
+    }
+    return {24, 16, 8, 0};
+}
+
+static inline void
+resolveLanes(const fsr32 *red, const fsr32 *green, const fsr32 *blue, const fsr32 *sampleCount, mnToneMapper toneMapper,
+             const PixelShifts& shifts, fsi32 *pixels) {
+    fsWide zero = fs_wide_set1(0.f);
+    fsWide count = fs_wide_load(sampleCount);
+    fsWide scale = fs_wide_select(count > zero, fs_wide_set1(1.f) / count, zero);
+    
+    fsWideInt r = toByte(encodeSRGB(toneMap(fs_wide_load(red) * scale, toneMapper)));
+    fsWideInt g = toByte(encodeSRGB(toneMap(fs_wide_load(green) * scale, toneMapper)));
+    fsWideInt b = toByte(encodeSRGB(toneMap(fs_wide_load(blue) * scale, toneMapper)));
+    fsWideInt alpha = fs_wide_int_set1((fsi32)(0xffu << shifts.alpha));
+    fsWideInt pixel = fs_wide_int_shl(r, shifts.red) | fs_wide_int_shl(g, shifts.green) | fs_wide_int_shl(b, shifts.blue) | alpha;
+    fs_wide_int_store(pixels, pixel);
+}
+
+
+#pragma mark - Resolve
+
+void
+mn_resolve_pixels(const fsr32 *red, const fsr32 *green, const fsr32 *blue, const fsr32 *sampleCount, fsu32 count,
+                  mnToneMapper toneMapper, mnPixelFormat format, fsu32 *pixels) {
+    PixelShifts shifts = getPixelShifts(format);
+    fsu32 i = 0;
+    for (; i + FS_SIMD_WIDTH <= count; i += FS_SIMD_WIDTH) {
+        resolveLanes(red + i, green + i, blue + i, sampleCount + i, toneMapper, shifts, (fsi32 *)(pixels + i));
+    }
+    
+    // The last partial set of lanes goes through copies, with no samples in the unused lanes.
+    fsu32 remaining = count - i;
+    if (remaining > 0) {
+        fsr32 tail[4][FS_SIMD_WIDTH] = {};
+        fsi32 tailPixels[FS_SIMD_WIDTH];
+        for (fsu32 lane = 0; lane < remaining; ++lane) {
+            tail[0][lane] = red[i + lane];
+            tail[1][lane] = green[i + lane];
+            tail[2][lane] = blue[i + lane];
+            tail[3][lane] = sampleCount[i + lane];
+        }
+        resolveLanes(tail[0], tail[1], tail[2], tail[3], toneMapper, shifts, tailPixels);
+        for (fsu32 lane = 0; lane < remaining; ++lane) {
+            pixels[i + lane] = (fsu32)tailPixels[lane];
+        }
+    }
+}
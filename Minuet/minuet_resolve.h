@@ -0,0 +1,30 @@
+//
+//  minuet_resolve.h
+//  Minuet
+//
+//  Created by Christian Floisand on 2026-10-16.
+//
+
+#pragma once
+#include "minuet_platform.h"
+
+
+#pragma mark - Resolve
+
+enum struct mnToneMapper {
+    clamp,      // Clips each channel at 1
+    reinhard,   // x / (1 + x) per channel; never clips, but flattens highlights
+    aces,       // Narkowicz's fit of the ACES filmic curve
+};
+
+enum struct mnPixelFormat {
+    rgba32,     // One 32-bit word per pixel, red in the high byte and alpha in the low one; what mnImage holds
+    rgba8,      // Bytes R, G, B, A in memory
+    bgra8,      // Bytes B, G, R, A in memory
+};
+
+/*! @brief Turns \c count pixels of linear radiance into display pixels: each pixel's sums are divided by its sample count,
+    tonemapped with \c toneMapper, sRGB encoded and packed as opaque 8-bit pixels in \c format. The channels and counts are
+    separate arrays so the kernel works on a full SIMD width of pixels at a time. Pixels without samples are black. */
+void mn_resolve_pixels(const fsr32 *red, const fsr32 *green, const fsr32 *blue, const fsr32 *sampleCount, fsu32 count,
+                       mnToneMapper toneMapper, mnPixelFormat format, fsu32 *pixels);
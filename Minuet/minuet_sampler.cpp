@@ -0,0 +1,218 @@
+//
+//  minuet_sampler.cpp
+//  Minuet
+//
+//  Created by Christian Floisand on 2026-10-16.
+//
+
+#include "minuet_sampler.h"
+#include <vector>
+
+
+#pragma mark - Hashing and scrambling
+
+static inline fsu32
+hashCombine(fsu32 seed, fsu32 value) {
+    return pcgHash(seed ^ (value + 0x9e3779b9u + (seed << 6) + (seed >> 2)));
+}
+
+static inline fsr32
+toUnitFloat(fsu32 bits) {
+    // The top 24 bits, so the result is always below 1.
+    return (fsr32)(bits >> 8) * (1.f / 16777216.f);
+}
+
+static inline fsu32
+reverseBits(fsu32 x) {
+    x = ((x >> 1) & 0x55555555u) | ((x & 0x55555555u) << 1);
+    x = ((x >> 2) & 0x33333333u) | ((x & 0x33333333u) << 2);
+    x = ((x >> 4) & 0x0f0f0f0fu) | ((x & 0x0f0f0f0fu) << 4);
+    x = ((x >> 8) & 0x00ff00ffu) | ((x & 0x00ff00ffu) << 8);
+    return (x >> 16) | (x << 16);
+}
+
+/*! @brief Owen scrambling of the bits of \c x, from Burley, "Practical Hash-based Owen Scrambling" (2020). Each bit is
+    flipped depending only on the bits above it, so values that share a prefix of high bits keep sharing one. */
+static inline fsu32
+nestedUniformScramble(fsu32 x, fsu32 seed) {
+    x = reverseBits(x);
+    x += seed;
+    x ^= x * 0x6c50b47cu;
+    x ^= x * 0xb82f1e52u;
+    x ^= x * 0xc7afe638u;
+    x ^= x * 0x8d22f6e6u;
+    return reverseBits(x);
+}
+
+/*! @brief One of the first two dimensions of the Sobol sequence, as 32-bit fixed point. */
+static inline fsu32
+sobol(fsu32 index, fsu32 dimension) {
+    if (dimension == 0) {
+        return reverseBits(index);
+    }
+    
+    // The second dimension's direction numbers are each the previous one xor itself shifted down by one.
+    fsu32 result = 0;
+    for (fsu32 direction = 0x80000000u; index; index >>= 1, direction ^= direction >> 1) {
+        if (index & 1) {
+            result ^= direction;
+        }
+    }
+    return result;
+}
+
+/*! @brief Dimension \c dimension of sample \c sampleIndex of a padded, shuffled and scrambled Sobol sequence. Dimensions are
+    taken in pairs from the 2D sequence, each pair with its own shuffle of the sample order and its own scramble. */
+static inline fsr32
+sobolSample(fsu32 sampleIndex, fsu32 dimension, fsu32 seed) {
+    fsu32 pairSeed = hashCombine(seed, dimension >> 1);
+    fsu32 index = nestedUniformScramble(sampleIndex, pairSeed);
+    fsu32 bits = sobol(index, dimension & 1);
+    return toUnitFloat(nestedUniformScramble(bits, hashCombine(pairSeed, dimension & 1)));
+}
+
+
+#pragma mark - Blue noise
+
+/*! @brief Ranks the pixels of a tileable kBlueNoiseSize square with Ulichney's void-and-cluster method, so that the first n
+    pixels in rank order are evenly spread for every n. */
+static std::vector<fsu16>
+makeBlueNoise() {
+    const fsi32 size = mnSampler::kBlueNoiseSize;
+    const fsi32 count = size * size;
+    const fsi32 mask = size - 1;
+    
+    // Gaussian energy kernel, wrapped around the edges so the result tiles.
+    const fsr32 sigma = 1.5f;
+    std::vector<fsr32> kernel(count);
+    for (fsi32 y = 0; y < size; ++y) {
+        for (fsi32 x = 0; x < size; ++x) {
+            fsr32 dx = (fsr32)fsMin(x, size - x);
+            fsr32 dy = (fsr32)fsMin(y, size - y);
+            kernel[x + y * size] = expf(-(dx * dx + dy * dy) / (2.f * sigma * sigma));
+        }
+    }
+    
+    std::vector<fsr32> energy(count, 0.f);
+    std::vector<fsu8> pattern(count, 0);
+    std::vector<fsu16> rank(count);
+    
+    auto toggle = [&](fsi32 index, bool set) {
+        pattern[index] = set;
+        fsr32 sign = (set ? 1.f : -1.f);
+        fsi32 px = index & mask;
+        fsi32 py = index / size;
+        for (fsi32 y = 0; y < size; ++y) {
+            const fsr32 *kernelRow = kernel.data() + ((y - py) & mask) * size;
+            fsr32 *energyRow = energy.data() + y * size;
+            for (fsi32 x = 0; x < size; ++x) {
+                energyRow[x] += sign * kernelRow[(x - px) & mask];
+            }
+        }
+    };
+    auto tightestCluster = [&]() {
+        fsi32 best = -1;
+        for (fsi32 i = 0; i < count; ++i) {
+            if (pattern[i] && (best < 0 || energy[i] > energy[best])) {
+                best = i;
+            }
+        }
+        return best;
+    };
+    auto largestVoid = [&]() {
+        fsi32 best = -1;
+        for (fsi32 i = 0; i < count; ++i) {
+            if (!pattern[i] && (best < 0 || energy[i] < energy[best])) {
+                best = i;
+            }
+        }
+        return best;
+    };
+    
+    // Initial pattern: a tenth of the pixels at random, relaxed by moving the tightest cluster into the largest void
+    // until that no longer changes anything.
+    const fsi32 initialCount = count / 10;
+    fsu32 seed = 1;
+    for (fsi32 placed = 0; placed < initialCount;) {
+        fsi32 index = (fsi32)(pcgHash(seed++) % count);
+        if (!pattern[index]) {
+            toggle(index, true);
+            placed++;
+        }
+    }
+    for (fsi32 iteration = 0; iteration < count; ++iteration) {
+        fsi32 cluster = tightestCluster();
+        toggle(cluster, false);
+        fsi32 hole = largestVoid();
+        toggle(hole, true);
+        if (hole == cluster) {
+            break;
+        }
+    }
+    
+    // The initial points are ranked by taking clusters away, and the rest by filling voids.
+    std::vector<fsr32> initialEnergy = energy;
+    std::vector<fsu8> initialPattern = pattern;
+    for (fsi32 r = initialCount - 1; r >= 0; --r) {
+        fsi32 cluster = tightestCluster();
+        toggle(cluster, false);
+        rank[cluster] = (fsu16)r;
+    }
+    energy.swap(initialEnergy);
+    pattern.swap(initialPattern);
+    for (fsi32 r = initialCount; r < count; ++r) {
+        fsi32 hole = largestVoid();
+        toggle(hole, true);
+        rank[hole] = (fsu16)r;
+    }
+    
+    return rank;
+}
+
+
+#pragma mark - mnSampler
+
+void
+mnSampler::configure(mnSamplerType type, fsu32 imageWidth) {
+    _type = type;
+    _imageWidth = fsMax(imageWidth, 1u);
+    if (type == mnSamplerType::blueNoise && !_blueNoise) {
+        static const std::vector<fsu16> blueNoise = makeBlueNoise();
+        _blueNoise = blueNoise.data();
+    }
+}
+
+fsr32
+mnSampler::get(fsu32 pixelIndex, fsu32 sampleIndex, fsu32 dimension) const {
+    switch (_type) {
+        case mnSamplerType::random:
+            return toUnitFloat(hashCombine(hashCombine(pcgHash(pixelIndex), sampleIndex), dimension));
+        
+        case mnSamplerType::stratified: {
+            // NOTE(christian): A sample's stratum is an Owen scramble of its place in the block, which is a random
+            // permutation of the strata that's different for each pixel, dimension and block.
+            fsu32 seed = hashCombine(hashCombine(pcgHash(pixelIndex), dimension), sampleIndex / kStratifiedBlockSize);
+            fsu32 stratum = nestedUniformScramble((sampleIndex % kStratifiedBlockSize) << (32 - kStratifiedBlockBits), seed);
+            stratum >>= 32 - kStratifiedBlockBits;
+            fsr32 jitter = toUnitFloat(hashCombine(seed, sampleIndex));
+            return fsMin((stratum + jitter) * (1.f / kStratifiedBlockSize), 0.99999994f);
+        }
+        
+        case mnSamplerType::sobol:
+            return sobolSample(sampleIndex, dimension, pcgHash(pixelIndex));
+        
+        case mnSamplerType::blueNoise: {
+            // NOTE(christian): Every pixel sees the same sequence, rotated by the mask (Cranley-Patterson), so neighbouring
+            // pixels get values that differ as much as possible. Each dimension reads the mask at its own offset.
+            fsu32 x = pixelIndex % _imageWidth;
+            fsu32 y = pixelIndex / _imageWidth;
+            fsu32 offset = pcgHash(dimension + 1);
+            x = (x + offset) & (kBlueNoiseSize - 1);
+            y = (y + (offset >> 16)) & (kBlueNoiseSize - 1);
+            fsr32 shift = (_blueNoise[x + y * kBlueNoiseSize] + 0.5f) * (1.f / (kBlueNoiseSize * kBlueNoiseSize));
+            fsr32 value = sobolSample(sampleIndex, dimension, 0) + shift;
+            return (value >= 1.f ? value - 1.f : value);
+        }
+    }
+    return 0.f;
+}
@@ -0,0 +1,52 @@
+//
+//  minuet_sampler.h
+//  Minuet
+//
+//  Created by Christian Floisand on 2026-10-16.
+//
+
+#pragma once
+#include "minuet_platform.h"
+
+
+#pragma mark - mnSampler
+
+enum struct mnSamplerType {
+    random,     // Independent uniform numbers for every pixel, sample and dimension
+    stratified, // Every dimension is stratified over each block of kStratifiedBlockSize samples, in a per-pixel random order
+    sobol,      // Owen-scrambled Sobol (0,2) sequence, padded to any number of dimensions and shuffled per pixel
+    blueNoise,  // One scrambled Sobol sequence for all pixels, offset per pixel by a blue noise mask
+};
+
+/*! @brief Which pixel and sample a path belongs to, and the first dimension of its current bounce. */
+struct mnSamplerState {
+    fsu32 pixelIndex;
+    fsu32 sampleIndex;
+    fsu32 dimension;
+};
+
+/*! @brief Produces the numbers in [0, 1) that paths use for their random decisions. Every number is a pure function of
+    (pixel, sample, dimension), so paths don't share state and any pass can be traced in any order. Dimensions only get the
+    benefit of the low-discrepancy samplers if each one means the same decision for every path, so callers should give each
+    decision a fixed dimension rather than drawing however many they need. The Sobol sequence is stratified in pairs of
+    dimensions (0, 1), (2, 3) and so on, so a 2D decision should take an even dimension and the one after it. */
+struct mnSampler {
+    static const fsu32 kStratifiedBlockBits = 4;
+    static const fsu32 kStratifiedBlockSize = 1 << kStratifiedBlockBits;
+    static const fsu32 kBlueNoiseSize = 64; // Width and height of the tiled blue noise mask; a power of two
+    
+    /*! @brief Switches to \c type for an image \c imageWidth pixels wide. The blue noise mask is generated the first time it's
+        needed, which takes a moment. */
+    void configure(mnSamplerType type, fsu32 imageWidth);
+    
+    fsr32 get(fsu32 pixelIndex, fsu32 sampleIndex, fsu32 dimension) const;
+    /*! @brief The number \c offset dimensions past the start of the path's current bounce. */
+    fsr32 get(const mnSamplerState& state, fsu32 offset) const {
+        return get(state.pixelIndex, state.sampleIndex, state.dimension + offset);
+    }
+
+private:
+    mnSamplerType _type = mnSamplerType::random;
+    fsu32 _imageWidth = 1;
+    const fsu16 *_blueNoise = nullptr; // Rank of every mask pixel, 0 to kBlueNoiseSize^2 - 1
+};
@@ -8,6 +8,7 @@
 
 #pragma once
 #include "minuet_platform.h"
+#include <memory>
 #include <vector>
 
 
@@ -27,7 +28,72 @@ struct mnSphere {
     fsi32 materialIndex = 0;
 };
 
+/*! @brief An indexed triangle mesh. Vertex positions are kept as separate x, y and z arrays, and every three entries of
+    \c indices make one triangle. The whole mesh uses one material. */
+struct mnMesh {
+    std::vector<fsr32> positionX;
+    std::vector<fsr32> positionY;
+    std::vector<fsr32> positionZ;
+    std::vector<fsu32> indices;
+    fsi32 materialIndex = 0;
+    
+    fsu32 getVertexCount() const { return (fsu32)positionX.size(); }
+    fsu32 getTriangleCount() const { return (fsu32)(indices.size() / 3); }
+    fsv3f getVertex(fsu32 index) const { return {positionX[index], positionY[index], positionZ[index]}; }
+};
+
+/*! @brief One of the scene's arrays. It either owns its elements, or is a read-only view of elements that live elsewhere,
+    such as in a mapped scene file. A view is as cheap to copy as a pointer. The first non-const access to a view copies
+    its elements into the array so they can be edited, and leaves the viewed ones untouched. */
+template<typename T>
+struct mnSceneArray {
+    mnSceneArray() = default;
+    /*! @brief A view of the \c count elements at \c elements, which must outlive the array and every copy of it. */
+    mnSceneArray(const T *elements, size_t count) : _view(elements), _viewCount(count) {}
+    
+    size_t size() const { return (_view ? _viewCount : _elements.size()); }
+    bool empty() const { return (size() == 0); }
+    bool isView() const { return (_view != nullptr); }
+    
+    const T* data() const { return (_view ? _view : _elements.data()); }
+    const T& operator[](size_t i) const { return data()[i]; }
+    const T* begin() const { return data(); }
+    const T* end() const { return data() + size(); }
+    
+    T* data() { detach(); return _elements.data(); }
+    T& operator[](size_t i) { detach(); return _elements[i]; }
+    T* begin() { return data(); }
+    T* end() { return data() + size(); }
+    
+    void push_back(const T& element) { detach(); _elements.push_back(element); }
+    void reserve(size_t count) { detach(); _elements.reserve(count); }
+    void resize(size_t count) { detach(); _elements.resize(count); }
+    void clear() { _view = nullptr; _viewCount = 0; _elements.clear(); }
+
+private:
+    void detach() {
+        if (_view) {
+            _elements.assign(_view, _view + _viewCount);
+            _view = nullptr;
+            _viewCount = 0;
+        }
+    }
+
+private:
+    std::vector<T> _elements;
+    const T *_view = nullptr;
+    size_t _viewCount = 0;
+};
+
 struct mnScene {
-    std::vector<mnSphere> spheres;
-    std::vector<mnMaterial> materials;
+    mnSceneArray<mnSphere> spheres;
+    mnSceneArray<mnMaterial> materials;
+    std::vector<mnMesh> meshes;
+    
+    // Keeps whatever the arrays view alive, such as a mapped scene file. Copies of the scene share it.
+    std::shared_ptr<const void> storage;
+    
+    // Bumped whenever spheres, materials or meshes are edited, so renderers know to refit or rebuild the data they derive
+    // from the scene.
+    fsu32 revision = 0;
 };
@@ -0,0 +1,497 @@
+//
+//  minuet_scene_file.cpp
+//  Minuet
+//
+//  Created by Christian Floisand on 2026-10-16.
+//
+
+#include "minuet_scene_file.h"
+#include <cstring>
+#include <type_traits>
+
+
+static void
+setError(std::string *error, const std::string& message) {
+    if (error) {
+        *error = message;
+    }
+}
+
+static bool
+validateMaterialIndices(const mnScene& scene, std::string *error) {
+    for (size_t i = 0; i < scene.spheres.size(); ++i) {
+        fsi32 materialIndex = scene.spheres[i].materialIndex;
+        if (materialIndex < 0 || (size_t)materialIndex >= scene.materials.size()) {
+            setError(error, "sphere " + std::to_string(i) + " refers to material " + std::to_string(materialIndex) +
+                            ", but there are " + std::to_string(scene.materials.size()));
+            return false;
+        }
+    }
+    for (size_t i = 0; i < scene.meshes.size(); ++i) {
+        fsi32 materialIndex = scene.meshes[i].materialIndex;
+        if (materialIndex < 0 || (size_t)materialIndex >= scene.materials.size()) {
+            setError(error, "mesh " + std::to_string(i) + " refers to material " + std::to_string(materialIndex) +
+                            ", but there are " + std::to_string(scene.materials.size()));
+            return false;
+        }
+    }
+    return true;
+}
+
+/*! @brief Meshes are loaded from the OBJ files scene files refer to, so they can't be written back out. */
+static bool
+validateWritable(const mnScene& scene, std::string *error) {
+    if (!scene.meshes.empty()) {
+        setError(error, "the scene has " + std::to_string(scene.meshes.size()) +
+                        " meshes, which can't be written to a scene file");
+        return false;
+    }
+    return validateMaterialIndices(scene, error);
+}
+
+
+#pragma mark - Binary format
+
+// NOTE(christian): The arrays are stored as they are in memory, so their layout is the format. Changing either struct
+// means bumping kBinaryVersion; the element sizes in the header catch builds that disagree about it anyway.
+static_assert(std::is_trivially_copyable<mnSphere>::value && sizeof(mnSphere) == 20, "mnSphere layout changed");
+static_assert(std::is_trivially_copyable<mnMaterial>::value && sizeof(mnMaterial) == 36, "mnMaterial layout changed");
+
+static const char kBinaryMagic[8] = {'M', 'N', 'S', 'C', 'E', 'N', 'E', '\0'};
+static const fsu32 kBinaryVersion = 1;
+static const fsu64 kBlockAlignment = 64;
+
+/*! @brief Starts every binary scene file. All values are little-endian, and offsets are from the start of the file. */
+struct mnSceneFileHeader {
+    char magic[8];
+    fsu32 version;
+    fsu32 headerSize;
+    fsu32 sphereSize;       // sizeof(mnSphere) of the writer
+    fsu32 materialSize;     // sizeof(mnMaterial) of the writer
+    fsu64 sphereCount;
+    fsu64 sphereOffset;
+    fsu64 materialCount;
+    fsu64 materialOffset;
+    fsu64 fileSize;
+};
+
+static bool
+isBinarySceneFile(const void *data, size_t size) {
+    return (size >= sizeof(kBinaryMagic) && memcmp(data, kBinaryMagic, sizeof(kBinaryMagic)) == 0);
+}
+
+/*! @brief Checks that a block of \c count elements of \c elementSize bytes at \c offset is aligned and lies within the file. */
+static bool
+isValidBlock(fsu64 offset, fsu64 count, fsu64 elementSize, fsu64 fileSize) {
+    if (offset % kBlockAlignment != 0 || offset > fileSize) {
+        return false;
+    }
+    return (count <= (fileSize - offset) / elementSize);
+}
+
+mnScene*
+mn_load_scene_binary(const char *path, std::string *error) {
+    size_t fileSize = 0;
+    const void *fileData = fs_map_file(path, &fileSize);
+    if (!fileData) {
+        setError(error, "could not open '" + std::string(path) + "'");
+        return nullptr;
+    }
+    std::shared_ptr<const void> storage(fileData, [fileSize](const void *data) { fs_unmap_file(data, fileSize); });
+    
+    const fsu8 *bytes = (const fsu8 *)fileData;
+    mnSceneFileHeader header;
+    if (!isBinarySceneFile(bytes, fileSize) || fileSize < sizeof(header)) {
+        setError(error, "'" + std::string(path) + "' is not a binary scene file");
+        return nullptr;
+    }
+    fs_memcpy(bytes, &header, sizeof(header));
+    
+    if (header.version != kBinaryVersion) {
+        setError(error, "'" + std::string(path) + "' is version " + std::to_string(header.version) + ", expected " +
+                        std::to_string(kBinaryVersion));
+        return nullptr;
+    }
+    if (header.headerSize != sizeof(header) || header.sphereSize != sizeof(mnSphere) ||
+        header.materialSize != sizeof(mnMaterial) || header.fileSize != fileSize ||
+        !isValidBlock(header.sphereOffset, header.sphereCount, sizeof(mnSphere), fileSize) ||
+        !isValidBlock(header.materialOffset, header.materialCount, sizeof(mnMaterial), fileSize)) {
+        setError(error, "'" + std::string(path) + "' is damaged or was written with a different layout");
+        return nullptr;
+    }
+    
+    mnScene *scene = new mnScene;
+    scene->spheres = mnSceneArray<mnSphere>((const mnSphere *)(bytes + header.sphereOffset), header.sphereCount);
+    scene->materials = mnSceneArray<mnMaterial>((const mnMaterial *)(bytes + header.materialOffset), header.materialCount);
+    scene->storage = std::move(storage);
+    
+    // NOTE(christian): This reads in every page of the sphere block, but the first render would read them all anyway, and
+    // a damaged or hostile file must not be able to send the renderer out of bounds.
+    std::string indexError;
+    if (!validateMaterialIndices(*scene, &indexError)) {
+        setError(error, "'" + std::string(path) + "' is damaged: " + indexError);
+        delete scene;
+        return nullptr;
+    }
+    return scene;
+}
+
+static bool
+writePadding(FILE *file, fsu64 offset) {
+    static const fsu8 kZeros[kBlockAlignment] = {};
+    fsu64 padding = fs_next_multiple(offset, kBlockAlignment) - offset;
+    return (padding == 0 || fwrite(kZeros, 1, padding, file) == padding);
+}
+
+bool
+mn_write_scene_binary(const mnScene& scene, const char *path, std::string *error) {
+    if (!validateWritable(scene, error)) {
+        return false;
+    }
+    
+    mnSceneFileHeader header = {};
+    memcpy(header.magic, kBinaryMagic, sizeof(kBinaryMagic));
+    header.version = kBinaryVersion;
+    header.headerSize = sizeof(header);
+    header.sphereSize = sizeof(mnSphere);
+    header.materialSize = sizeof(mnMaterial);
+    header.sphereCount = scene.spheres.size();
+    header.sphereOffset = fs_next_multiple((fsu64)sizeof(header), kBlockAlignment);
+    header.materialCount = scene.materials.size();
+    header.materialOffset = fs_next_multiple(header.sphereOffset + header.sphereCount * sizeof(mnSphere), kBlockAlignment);
+    header.fileSize = header.materialOffset + header.materialCount * sizeof(mnMaterial);
+    
+    FILE *file = fopen(path, "wb");
+    if (!file) {
+        setError(error, "could not create '" + std::string(path) + "'");
+        return false;
+    }
+    
+    bool ok = (fwrite(&header, sizeof(header), 1, file) == 1 && writePadding(file, sizeof(header)) &&
+               fwrite(scene.spheres.data(), sizeof(mnSphere), header.sphereCount, file) == header.sphereCount &&
+               writePadding(file, header.sphereOffset + header.sphereCount * sizeof(mnSphere)) &&
+               fwrite(scene.materials.data(), sizeof(mnMaterial), header.materialCount, file) == header.materialCount);
+    ok &= (fclose(file) == 0);
+    if (!ok) {
+        setError(error, "could not write '" + std::string(path) + "'");
+    }
+    return ok;
+}
+
+
+#pragma mark - Text format
+
+/*! @brief Reads the values of an object's properties off a tokenized line. */
+struct mnSceneTextReader {
+    fsTokenizer tokenizer;
+    fsStringView token;     // The last token read, or empty at the end of the line. Error messages quote it.
+    
+    bool nextToken() {
+        if (!tokenizer.next_token(&token)) {
+            token = fsStringView();
+            return false;
+        }
+        return true;
+    }
+    
+    bool readFloat(fsr32& value) {
+        return nextToken() && fs_parse_float(token, &value);
+    }
+    
+    bool readInteger(fsi32& value) {
+        fsi64 result;
+        if (!nextToken() || !fs_parse_integer(token, &result) || result < INT32_MIN || result > INT32_MAX) {
+            return false;
+        }
+        value = (fsi32)result;
+        return true;
+    }
+    
+    bool readVector(fsv3f& value) {
+        return readFloat(value.x) && readFloat(value.y) && readFloat(value.z);
+    }
+};
+
+static bool
+readMaterial(mnSceneTextReader& reader, mnMaterial& material) {
+    while (reader.nextToken()) {
+        bool ok;
+        if (fs_are_equal(reader.token, "albedo")) {
+            ok = reader.readVector(material.albedo);
+        } else if (fs_are_equal(reader.token, "roughness")) {
+            ok = reader.readFloat(material.roughness);
+        } else if (fs_are_equal(reader.token, "metallic")) {
+            ok = reader.readFloat(material.metallic);
+        } else if (fs_are_equal(reader.token, "emission")) {
+            ok = reader.readVector(material.emissionColor);
+        } else if (fs_are_equal(reader.token, "power")) {
+            ok = reader.readFloat(material.emissionPower);
+        } else {
+            ok = false;
+        }
+        if (!ok) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool
+readSphere(mnSceneTextReader& reader, mnSphere& sphere) {
+    while (reader.nextToken()) {
+        bool ok;
+        if (fs_are_equal(reader.token, "position")) {
+            ok = reader.readVector(sphere.position);
+        } else if (fs_are_equal(reader.token, "radius")) {
+            ok = reader.readFloat(sphere.radius);
+        } else if (fs_are_equal(reader.token, "material")) {
+            ok = reader.readInteger(sphere.materialIndex);
+        } else {
+            ok = false;
+        }
+        if (!ok) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*! @brief Reads a mesh line's properties. The OBJ file isn't loaded here, so that \c path can be resolved first. */
+static bool
+readMesh(mnSceneTextReader& reader, fsStringView& path, fsi32& materialIndex) {
+    while (reader.nextToken()) {
+        bool ok;
+        if (fs_are_equal(reader.token, "file")) {
+            ok = reader.nextToken();
+            path = reader.token;
+        } else if (fs_are_equal(reader.token, "material")) {
+            ok = reader.readInteger(materialIndex);
+        } else {
+            ok = false;
+        }
+        if (!ok) {
+            return false;
+        }
+    }
+    return (path.length > 0);
+}
+
+static mnScene*
+parseSceneText(const char *text, size_t length, const char *path, std::string *error) {
+    mnScene *scene = new mnScene;
+    mnSceneTextReader reader = {fsTokenizer(text, length, '#')};
+    do {
+        bool ok = true;
+        if (!reader.nextToken()) {
+            continue;
+        } else if (fs_are_equal(reader.token, "material")) {
+            mnMaterial material;
+            ok = readMaterial(reader, material);
+            scene->materials.push_back(material);
+        } else if (fs_are_equal(reader.token, "sphere")) {
+            mnSphere sphere;
+            ok = readSphere(reader, sphere);
+            scene->spheres.push_back(sphere);
+        } else if (fs_are_equal(reader.token, "mesh")) {
+            fsStringView meshPath;
+            fsi32 materialIndex = 0;
+            ok = readMesh(reader, meshPath, materialIndex);
+            if (ok) {
+                // Relative paths are relative to the scene file.
+                std::string objPath(meshPath.data, meshPath.length);
+                const char *slash = strrchr(path, '/');
+                if (objPath[0] != '/' && slash) {
+                    objPath.insert(0, path, slash - path + 1);
+                }
+                
+                scene->meshes.emplace_back();
+                scene->meshes.back().materialIndex = materialIndex;
+                std::string meshError;
+                if (!mn_load_obj(objPath.c_str(), scene->meshes.back(), &meshError)) {
+                    setError(error, std::string(path) + ":" + std::to_string(reader.tokenizer.lineNumber) + ": " + meshError);
+                    delete scene;
+                    return nullptr;
+                }
+            }
+        } else {
+            ok = false;
+        }
+        
+        if (!ok) {
+            std::string token(reader.token.data, reader.token.length);
+            setError(error, std::string(path) + ":" + std::to_string(reader.tokenizer.lineNumber) + ": unexpected " +
+                            (token.empty() ? std::string("end of line") : "'" + token + "'"));
+            delete scene;
+            return nullptr;
+        }
+    } while (reader.tokenizer.next_line());
+    
+    if (!validateMaterialIndices(*scene, error)) {
+        delete scene;
+        return nullptr;
+    }
+    return scene;
+}
+
+mnScene*
+mn_load_scene_text(const char *path, std::string *error) {
+    size_t textSize = 0;
+    const char *text = (const char *)fs_map_file(path, &textSize);
+    if (!text) {
+        // NOTE(christian): An empty file can't be mapped, but it is a valid (empty) scene.
+        FILE *file = fopen(path, "rb");
+        bool isEmpty = (file && fgetc(file) == EOF);
+        if (file) {
+            fclose(file);
+        }
+        if (isEmpty) {
+            return new mnScene;
+        }
+        setError(error, "could not read '" + std::string(path) + "'");
+        return nullptr;
+    }
+    
+    mnScene *scene = parseSceneText(text, textSize, path, error);
+    fs_unmap_file(text, textSize);
+    return scene;
+}
+
+bool
+mn_write_scene_text(const mnScene& scene, const char *path, std::string *error) {
+    if (!validateWritable(scene, error)) {
+        return false;
+    }
+    
+    FILE *file = fopen(path, "w");
+    if (!file) {
+        setError(error, "could not create '" + std::string(path) + "'");
+        return false;
+    }
+    
+    // NOTE(christian): Nine significant digits are enough for any float to read back as exactly the same value.
+    fprintf(file, "# Minuet scene: %zu materials, %zu spheres\n", scene.materials.size(), scene.spheres.size());
+    for (const mnMaterial& material : scene.materials) {
+        fprintf(file, "material albedo %.9g %.9g %.9g roughness %.9g metallic %.9g emission %.9g %.9g %.9g power %.9g\n",
+                material.albedo.x, material.albedo.y, material.albedo.z, material.roughness, material.metallic,
+                material.emissionColor.x, material.emissionColor.y, material.emissionColor.z, material.emissionPower);
+    }
+    for (const mnSphere& sphere : scene.spheres) {
+        fprintf(file, "sphere position %.9g %.9g %.9g radius %.9g material %d\n", sphere.position.x, sphere.position.y,
+                sphere.position.z, sphere.radius, sphere.materialIndex);
+    }
+    
+    bool ok = (ferror(file) == 0);
+    ok &= (fclose(file) == 0);
+    if (!ok) {
+        setError(error, "could not write '" + std::string(path) + "'");
+    }
+    return ok;
+}
+
+
+#pragma mark - Either format
+
+mnScene*
+mn_load_scene_file(const char *path, std::string *error) {
+    char magic[sizeof(kBinaryMagic)] = {};
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        setError(error, "could not open '" + std::string(path) + "'");
+        return nullptr;
+    }
+    size_t readSize = fread(magic, 1, sizeof(magic), file);
+    fclose(file);
+    
+    if (isBinarySceneFile(magic, readSize)) {
+        return mn_load_scene_binary(path, error);
+    }
+    return mn_load_scene_text(path, error);
+}
+
+
+#pragma mark - Meshes
+
+/*! @brief Parses one vertex reference of an OBJ face, such as "3", "3/1", "3//2" or "-1/1/2", into a zero-based position
+    index. Only the position is used. Negative indices count back from the last vertex read so far. */
+static bool
+parseFaceVertex(fsStringView token, fsu32 vertexCount, fsu32& index) {
+    const char *slash = (const char *)memchr(token.data, '/', token.length);
+    fsStringView position = {token.data, (slash ? (size_t)(slash - token.data) : token.length)};
+    
+    fsi64 value;
+    if (!fs_parse_integer(position, &value) || value == 0) {
+        return false;
+    }
+    value = (value < 0 ? (fsi64)vertexCount + value : value - 1);
+    if (value < 0 || value > UINT32_MAX) {
+        return false;
+    }
+    index = (fsu32)value;
+    return true;
+}
+
+bool
+mn_load_obj(const char *path, mnMesh& mesh, std::string *error) {
+    size_t textSize = 0;
+    const char *text = (const char *)fs_map_file(path, &textSize);
+    if (!text) {
+        setError(error, "could not read '" + std::string(path) + "'");
+        return false;
+    }
+    
+    mesh.positionX.clear();
+    mesh.positionY.clear();
+    mesh.positionZ.clear();
+    mesh.indices.clear();
+    
+    mnSceneTextReader reader = {fsTokenizer(text, textSize, '#')};
+    bool ok = true;
+    do {
+        if (!reader.nextToken()) {
+            continue;
+        } else if (fs_are_equal(reader.token, "v")) {
+            // NOTE(christian): A fourth (w) coordinate or trailing vertex colors may follow; they're skipped.
+            fsv3f position;
+            ok = reader.readVector(position);
+            mesh.positionX.push_back(position.x);
+            mesh.positionY.push_back(position.y);
+            mesh.positionZ.push_back(position.z);
+        } else if (fs_are_equal(reader.token, "f")) {
+            // Polygons are split into a fan of triangles around their first vertex.
+            fsu32 vertexCount = mesh.getVertexCount();
+            fsu32 first = 0, previous = 0, index = 0;
+            fsu32 cornerCount = 0;
+            while (ok && reader.nextToken()) {
+                ok = parseFaceVertex(reader.token, vertexCount, index);
+                if (ok && cornerCount >= 2) {
+                    mesh.indices.push_back(first);
+                    mesh.indices.push_back(previous);
+                    mesh.indices.push_back(index);
+                }
+                first = (cornerCount == 0 ? index : first);
+                previous = index;
+                cornerCount++;
+            }
+            ok &= (cornerCount >= 3);
+        }
+        // Anything else, such as normals, texture coordinates, groups and materials, isn't used.
+        
+        if (!ok) {
+            std::string token(reader.token.data, reader.token.length);
+            setError(error, std::string(path) + ":" + std::to_string(reader.tokenizer.lineNumber) + ": unexpected " +
+                            (token.empty() ? std::string("end of line") : "'" + token + "'"));
+            break;
+        }
+    } while (reader.tokenizer.next_line());
+    fs_unmap_file(text, textSize);
+    
+    // NOTE(christian): Positive indices may refer to vertices further down the file, so they're only checked once it's read.
+    for (size_t i = 0; ok && i < mesh.indices.size(); ++i) {
+        if (mesh.indices[i] >= mesh.getVertexCount()) {
+            setError(error, std::string(path) + ": face refers to vertex " + std::to_string(mesh.indices[i] + 1) +
+                            ", but there are " + std::to_string(mesh.getVertexCount()));
+            ok = false;
+        }
+    }
+    return ok;
+}
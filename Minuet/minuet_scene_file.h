@@ -0,0 +1,57 @@
+//
+//  minuet_scene_file.h
+//  Minuet
+//
+//  Created by Christian Floisand on 2026-10-16.
+//
+//  Scene files come in two formats that hold the same thing.
+//
+//  The binary format (.mnb) is what production scenes are loaded from. A fixed header is followed by the sphere and material
+//  arrays, each stored exactly as mnSphere and mnMaterial are laid out in memory and starting on a cache line boundary. The
+//  file is mapped rather than read, and the scene's arrays view the mapping directly, so nothing is copied at load; the only
+//  pass over the spheres is the check that their material indices are in range.
+//
+//  The text format (.mns) is for writing scenes by hand and for converting from other tools. Each line is one object: a
+//  keyword followed by any of its properties as name/value pairs, in any order. Properties left out keep their defaults.
+//  Everything after a '#' is a comment. Materials are numbered in the order they appear.
+//
+//      material albedo 0.8 0.5 0.2 roughness 0.1 metallic 0 emission 0.8 0.5 0.2 power 2
+//      sphere position 2 0 0 radius 1 material 0
+//      mesh file bunny.obj material 0
+//
+//  A mesh line loads the triangles of an OBJ file, found relative to the scene file. Neither format can be written from a
+//  scene that has meshes, since the scene no longer knows which files they came from.
+//
+
+#pragma once
+#include "minuet_platform.h"
+#include "minuet_scene.h"
+#include <string>
+
+
+#pragma mark - Scene files
+
+/*! @brief Loads a scene from either format, telling them apart by the binary format's header. Returns null on failure,
+    with the reason in \c error if it's given. */
+mnScene* mn_load_scene_file(const char *path, std::string *error = nullptr);
+
+/*! @brief Maps a binary scene file. The scene's arrays view the mapping, which stays alive as long as the scene, or any copy
+    of it, does; editing them copies them out of the mapping first. Returns null on failure, including when a sphere refers
+    to a material the file doesn't have. */
+mnScene* mn_load_scene_binary(const char *path, std::string *error = nullptr);
+/*! @brief Writes \c scene in the binary format. Fails if an object refers to a material the scene doesn't have. */
+bool mn_write_scene_binary(const mnScene& scene, const char *path, std::string *error = nullptr);
+
+/*! @brief Parses a text scene file straight out of a mapping of it, a token at a time and without copying or allocating per
+    token, so even scenes of millions of objects load in seconds. Returns null on failure, with the offending line in \c error. */
+mnScene* mn_load_scene_text(const char *path, std::string *error = nullptr);
+/*! @brief Writes \c scene in the text format, with every property spelled out and enough digits to read back exactly. */
+bool mn_write_scene_text(const mnScene& scene, const char *path, std::string *error = nullptr);
+
+
+#pragma mark - Meshes
+
+/*! @brief Loads the vertex positions and faces of a Wavefront OBJ file into \c mesh, splitting polygons into triangles.
+    Normals, texture coordinates, groups and materials are ignored, and \c mesh keeps its material index. Returns false on
+    failure, with the offending line in \c error. */
+bool mn_load_obj(const char *path, mnMesh& mesh, std::string *error = nullptr);
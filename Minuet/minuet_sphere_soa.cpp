@@ -0,0 +1,199 @@
+//
+//  minuet_sphere_soa.cpp
+//  Minuet
+//
+//  Created by Christian Floisand on 2026-10-16.
+//
+
+#include "minuet_sphere_soa.h"
+#include "fs_simd.h"
+
+
+#pragma mark - mnSphereSoA
+
+mnSphereSoA::~mnSphereSoA() {
+    fs_aligned_free(_memory);
+}
+
+void
+mnSphereSoA::build(const mnScene& scene, const std::vector<fsu32>& order) {
+    fsAssert(order.size() == scene.spheres.size());
+    
+    count = (fsu32)order.size();
+    reserve(count);
+    
+    for (fsu32 i = 0; i < count; ++i) {
+        const mnSphere& sphere = scene.spheres[order[i]];
+        centerX[i] = sphere.position.x;
+        centerY[i] = sphere.position.y;
+        centerZ[i] = sphere.position.z;
+        radiusSq[i] = sphere.radius * sphere.radius;
+        sphereIndex[i] = (fsi32)order[i];
+    }
+}
+
+void
+mnSphereSoA::reserve(fsu32 capacity) {
+    // NOTE(christian): One extra SIMD width of padding lets the kernel load whole lane groups past the end of a range; the
+    // padding lanes are masked out by index, but are also set up so that they can never produce a hit.
+    fsu32 paddedCapacity = fs_next_multiple(capacity, (fsu32)FS_SIMD_WIDTH) + FS_SIMD_WIDTH;
+    if (paddedCapacity <= _capacity && _memory) {
+        return;
+    }
+    
+    fs_aligned_free(_memory);
+    
+    size_t arraySize = fs_next_multiple((size_t)paddedCapacity * sizeof(fsr32), (size_t)FS_SIMD_ALIGNMENT);
+    _memory = fs_aligned_alloc(arraySize * 5, FS_SIMD_ALIGNMENT);
+    _capacity = paddedCapacity;
+    
+    fsu8 *at = (fsu8 *)_memory;
+    centerX = (fsr32 *)at; at += arraySize;
+    centerY = (fsr32 *)at; at += arraySize;
+    centerZ = (fsr32 *)at; at += arraySize;
+    radiusSq = (fsr32 *)at; at += arraySize;
+    sphereIndex = (fsi32 *)at;
+    
+    for (fsu32 i = 0; i < _capacity; ++i) {
+        centerX[i] = centerY[i] = centerZ[i] = 0.f;
+        radiusSq[i] = -INFINITY;
+        sphereIndex[i] = -1;
+    }
+}
+
+
+#pragma mark - Kernel
+
+bool
+mn_intersect_spheres(const mnSphereSoA& spheres, fsu32 first, fsu32 count, const mnRay& ray, fsr32& hitDistance, fsu32& lane) {
+    fsr32 a = fs_vdot(ray.direction, ray.direction);
+    
+    fsWide originX = fs_wide_set1(ray.origin.x);
+    fsWide originY = fs_wide_set1(ray.origin.y);
+    fsWide originZ = fs_wide_set1(ray.origin.z);
+    fsWide directionX = fs_wide_set1(ray.direction.x);
+    fsWide directionY = fs_wide_set1(ray.direction.y);
+    fsWide directionZ = fs_wide_set1(ray.direction.z);
+    fsWide wideA = fs_wide_set1(a);
+    fsWide inverseA = fs_wide_set1(1.f / a);
+    fsWide zero = fs_wide_set1(0.f);
+    fsWideInt end = fs_wide_int_set1((fsi32)(first + count));
+    
+    fsWide closestT = fs_wide_set1(hitDistance);
+    fsWideInt closestLane = fs_wide_int_set1(-1);
+    
+    for (fsu32 i = first; i < first + count; i += FS_SIMD_WIDTH) {
+        fsWide ocX = originX - fs_wide_load(spheres.centerX + i);
+        fsWide ocY = originY - fs_wide_load(spheres.centerY + i);
+        fsWide ocZ = originZ - fs_wide_load(spheres.centerZ + i);
+        
+        // NOTE(christian): Half-b form of the quadratic: t = (-b - sqrt(b^2 - ac)) / a, with b = dot(oc, d).
+        fsWide b = ocX * directionX + ocY * directionY + ocZ * directionZ;
+        fsWide c = ocX * ocX + ocY * ocY + ocZ * ocZ - fs_wide_load(spheres.radiusSq + i);
+        fsWide discriminant = b * b - wideA * c;
+        fsWide t = (-b - fs_wide_sqrt(fs_wide_max(discriminant, zero))) * inverseA;
+        
+        fsWideInt laneIndex = fs_wide_int_ramp((fsi32)i);
+        fsWideMask hit = (discriminant >= zero) & (t > zero) & (t < closestT) & (laneIndex < end);
+        closestT = fs_wide_select(hit, t, closestT);
+        closestLane = fs_wide_select(hit, laneIndex, closestLane);
+    }
+    
+    fsr32 minT = fs_wide_hmin(closestT);
+    if (minT >= hitDistance) {
+        return false;
+    }
+    
+    // Horizontal min found the distance; pick the lane that holds it.
+    fsu32 bits = fs_wide_movemask(closestT == fs_wide_set1(minT));
+    fsi32 lanes[FS_SIMD_WIDTH];
+    fs_wide_int_store(lanes, closestLane);
+    
+    fsu32 winner = fs_ffs(bits) - 1;
+    
+    hitDistance = minT;
+    lane = (fsu32)lanes[winner];
+    return true;
+}
+
+bool
+mn_occluded_spheres(const mnSphereSoA& spheres, fsu32 first, fsu32 count, const mnRay& ray, fsr32 maxDistance) {
+    fsr32 a = fs_vdot(ray.direction, ray.direction);
+    
+    fsWide originX = fs_wide_set1(ray.origin.x);
+    fsWide originY = fs_wide_set1(ray.origin.y);
+    fsWide originZ = fs_wide_set1(ray.origin.z);
+    fsWide directionX = fs_wide_set1(ray.direction.x);
+    fsWide directionY = fs_wide_set1(ray.direction.y);
+    fsWide directionZ = fs_wide_set1(ray.direction.z);
+    fsWide wideA = fs_wide_set1(a);
+    fsWide inverseA = fs_wide_set1(1.f / a);
+    fsWide zero = fs_wide_set1(0.f);
+    fsWide tMax = fs_wide_set1(maxDistance);
+    fsWideInt end = fs_wide_int_set1((fsi32)(first + count));
+    
+    for (fsu32 i = first; i < first + count; i += FS_SIMD_WIDTH) {
+        fsWide ocX = originX - fs_wide_load(spheres.centerX + i);
+        fsWide ocY = originY - fs_wide_load(spheres.centerY + i);
+        fsWide ocZ = originZ - fs_wide_load(spheres.centerZ + i);
+        
+        fsWide b = ocX * directionX + ocY * directionY + ocZ * directionZ;
+        fsWide c = ocX * ocX + ocY * ocY + ocZ * ocZ - fs_wide_load(spheres.radiusSq + i);
+        fsWide discriminant = b * b - wideA * c;
+        fsWide t = (-b - fs_wide_sqrt(fs_wide_max(discriminant, zero))) * inverseA;
+        
+        fsWideInt laneIndex = fs_wide_int_ramp((fsi32)i);
+        fsWideMask hit = (discriminant >= zero) & (t > zero) & (t < tMax) & (laneIndex < end);
+        if (fs_wide_movemask(hit) != 0) {
+            return true;
+        }
+    }
+    
+    return false;
+}
+
+fsu32
+mn_intersect_spheres_packet(const mnSphereSoA& spheres, fsu32 first, fsu32 count, mnRayPacket& packet) {
+    fsr32 maxDistance = packet.getMaxHitDistance();
+    fsWide zero = fs_wide_set1(0.f);
+    fsu32 testedCount = 0;
+    
+    for (fsu32 sphere = first; sphere < first + count; ++sphere) {
+        fsr32 radius = sqrtf(spheres.radiusSq[sphere]);
+        fsv3f center = {spheres.centerX[sphere], spheres.centerY[sphere], spheres.centerZ[sphere]};
+        fsv3f extent = {radius, radius, radius};
+        if (mn_intersect_aabb_packet(packet, center - extent, center + extent, maxDistance) == FLT_MAX) {
+            continue;
+        }
+        testedCount++;
+        
+        fsWide centerX = fs_wide_set1(center.x);
+        fsWide centerY = fs_wide_set1(center.y);
+        fsWide centerZ = fs_wide_set1(center.z);
+        fsWide radiusSq = fs_wide_set1(spheres.radiusSq[sphere]);
+        fsWideInt object = fs_wide_int_set1(spheres.sphereIndex[sphere]);
+        
+        for (fsu32 i = 0; i < packet.paddedCount; i += FS_SIMD_WIDTH) {
+            fsWide directionX = fs_wide_load(packet.directionX + i);
+            fsWide directionY = fs_wide_load(packet.directionY + i);
+            fsWide directionZ = fs_wide_load(packet.directionZ + i);
+            fsWide ocX = fs_wide_load(packet.originX + i) - centerX;
+            fsWide ocY = fs_wide_load(packet.originY + i) - centerY;
+            fsWide ocZ = fs_wide_load(packet.originZ + i) - centerZ;
+            
+            // Same half-b quadratic as mn_intersect_spheres, with the ray and sphere roles swapped across lanes.
+            fsWide a = directionX * directionX + directionY * directionY + directionZ * directionZ;
+            fsWide b = ocX * directionX + ocY * directionY + ocZ * directionZ;
+            fsWide c = ocX * ocX + ocY * ocY + ocZ * ocZ - radiusSq;
+            fsWide discriminant = b * b - a * c;
+            fsWide t = (-b - fs_wide_sqrt(fs_wide_max(discriminant, zero))) * (fs_wide_set1(1.f) / a);
+            
+            fsWide closestT = fs_wide_load(packet.hitDistance + i);
+            fsWideMask hit = (discriminant >= zero) & (t > zero) & (t < closestT);
+            fs_wide_store(packet.hitDistance + i, fs_wide_select(hit, t, closestT));
+            fs_wide_int_store(packet.hitObject + i, fs_wide_select(hit, object, fs_wide_int_load(packet.hitObject + i)));
+        }
+    }
+    
+    return testedCount;
+}
@@ -0,0 +1,57 @@
+//
+//  minuet_sphere_soa.h
+//  Minuet
+//
+//  Created by Christian Floisand on 2026-10-16.
+//
+
+#pragma once
+#include "minuet_platform.h"
+#include "minuet_ray.h"
+#include "minuet_ray_packet.h"
+#include "minuet_scene.h"
+#include <vector>
+
+
+#pragma mark - mnSphereSoA
+
+/*! @brief A packed structure-of-arrays mirror of the scene's spheres for the wide intersection kernel. Each array is aligned and
+    padded by one SIMD width, so the kernel can always load a full set of lanes. Spheres are stored in the order given to
+    \c build (the BVH's primitive order), so every BVH leaf maps to a contiguous run of lanes. */
+struct mnSphereSoA {
+    mnSphereSoA() = default;
+    ~mnSphereSoA();
+    
+    mnSphereSoA(const mnSphereSoA&) = delete;
+    mnSphereSoA& operator=(const mnSphereSoA&) = delete;
+    
+    /*! @brief Fills the lanes from \c scene, where lane \c i holds the sphere at \c scene.spheres[order[i]]. */
+    void build(const mnScene& scene, const std::vector<fsu32>& order);
+    
+public:
+    fsr32 *centerX = nullptr;
+    fsr32 *centerY = nullptr;
+    fsr32 *centerZ = nullptr;
+    fsr32 *radiusSq = nullptr;
+    fsi32 *sphereIndex = nullptr;   // Index into mnScene::spheres.
+    fsu32 count = 0;
+    
+private:
+    void reserve(fsu32 capacity);
+    
+private:
+    void *_memory = nullptr;
+    fsu32 _capacity = 0;
+};
+
+/*! @brief Intersects \c ray with lanes [first, first + count) several spheres at a time. If a hit closer than \c hitDistance is
+    found, \c hitDistance and \c lane are updated and true is returned. */
+bool mn_intersect_spheres(const mnSphereSoA& spheres, fsu32 first, fsu32 count, const mnRay& ray, fsr32& hitDistance, fsu32& lane);
+
+/*! @brief Returns true as soon as any of lanes [first, first + count) is hit by \c ray closer than \c maxDistance. Used for shadow
+    rays, which only need to know whether something is in the way, not what is closest. */
+bool mn_occluded_spheres(const mnSphereSoA& spheres, fsu32 first, fsu32 count, const mnRay& ray, fsr32 maxDistance);
+
+/*! @brief Intersects every ray in \c packet with lanes [first, first + count), several rays at a time. Spheres whose bounds the
+    packet can't reach are skipped. Updates each ray's \c hitDistance and \c hitObject, and returns the number of spheres tested. */
+fsu32 mn_intersect_spheres_packet(const mnSphereSoA& spheres, fsu32 first, fsu32 count, mnRayPacket& packet);
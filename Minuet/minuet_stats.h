@@ -0,0 +1,59 @@
+//
+//  minuet_stats.h
+//  Minuet
+//
+//  Created by Christian Floisand on 2026-10-16.
+//
+
+#pragma once
+#include <stdint.h>
+
+/* NOTE(christian): Build with MN_STATS=0 to compile out every counter except the total ray count, which is a single
+   increment per bounce and is needed for rays/s figures. */
+#ifndef MN_STATS
+#   define MN_STATS 1
+#endif
+
+#define MN_STATS_MAX_DEPTH 16
+
+/*! @brief Counters gathered over one call to render. Written by the C API, so plain C. */
+typedef struct mnRenderStats {
+    uint64_t rayCount;                          // Every ray traced: primary, secondary and shadow
+    uint64_t raysPerDepth[MN_STATS_MAX_DEPTH];  // Rays traced at each bounce depth; deeper bounces land in the last entry
+    uint64_t sphereTests;                       // Ray-sphere intersection tests, including those in BVH leaves
+    uint64_t triangleTests;                     // Ray-triangle intersection tests, including those in mesh BVH leaves
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t shadowRays;
+    uint64_t shadowRaysOccluded;
+    uint64_t pathsEscaped;                      // Paths that left the scene before reaching the bounce limit
+    uint64_t pathsTerminatedByDepth;            // Paths cut off at the bounce limit
+    uint64_t pathsTerminatedByRoulette;
+} mnRenderStats;
+
+#ifdef __cplusplus
+
+#if MN_STATS
+#   define mnStat(expr) expr
+#else
+#   define mnStat(expr)
+#endif
+
+inline void
+mn_stats_merge(mnRenderStats& into, const mnRenderStats& from) {
+    into.rayCount += from.rayCount;
+    for (int depth = 0; depth < MN_STATS_MAX_DEPTH; ++depth) {
+        into.raysPerDepth[depth] += from.raysPerDepth[depth];
+    }
+    into.sphereTests += from.sphereTests;
+    into.triangleTests += from.triangleTests;
+    into.hits += from.hits;
+    into.misses += from.misses;
+    into.shadowRays += from.shadowRays;
+    into.shadowRaysOccluded += from.shadowRaysOccluded;
+    into.pathsEscaped += from.pathsEscaped;
+    into.pathsTerminatedByDepth += from.pathsTerminatedByDepth;
+    into.pathsTerminatedByRoulette += from.pathsTerminatedByRoulette;
+}
+
+#endif
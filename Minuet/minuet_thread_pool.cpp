@@ -0,0 +1,183 @@
+//
+//  minuet_thread_pool.cpp
+//  Minuet
+//
+//  Created by Christian Floisand on 2026-10-16.
+//
+
+#include "minuet_thread_pool.h"
+
+
+#pragma mark - mnTile
+
+void
+mn_make_tiles(fsu32 width, fsu32 height, fsu32 tileSize, std::vector<mnTile>& tiles) {
+    fsAssert(tileSize > 0);
+    tiles.clear();
+    
+    for (fsu32 y = 0; y < height; y += tileSize) {
+        for (fsu32 x = 0; x < width; x += tileSize) {
+            mnTile tile;
+            tile.x0 = x;
+            tile.y0 = y;
+            tile.x1 = fsMin(x + tileSize, width);
+            tile.y1 = fsMin(y + tileSize, height);
+            tiles.push_back(tile);
+        }
+    }
+}
+
+
+#pragma mark - mnThreadPool
+
+mnThreadPool::mnThreadPool(fsu32 workerCount)
+    : _remainingJobs(0)
+{
+    start(workerCount);
+}
+
+mnThreadPool::~mnThreadPool() {
+    stop();
+}
+
+void
+mnThreadPool::setWorkerCount(fsu32 workerCount) {
+    if (workerCount == 0) {
+        workerCount = fsMax(std::thread::hardware_concurrency(), 1u);
+    }
+    
+    if (workerCount != _workerCount) {
+        stop();
+        start(workerCount);
+    }
+}
+
+void
+mnThreadPool::run(fsu32 jobCount, const JobFunc& func) {
+    if (jobCount == 0) {
+        return;
+    }
+    
+    {
+        std::lock_guard<std::mutex> guard(_wakeLock);
+        _job = &func;
+        _remainingJobs.store(jobCount);
+    }
+    
+    // NOTE(christian): Jobs are dealt out in contiguous runs so each worker starts on a coherent region of the image; idle workers
+    // then steal from the far end of the busiest deques.
+    for (fsu32 w = 0; w < _workerCount; ++w) {
+        fsu32 first = (fsu32)(((fsu64)jobCount * w) / _workerCount);
+        fsu32 last = (fsu32)(((fsu64)jobCount * (w + 1)) / _workerCount);
+        
+        std::lock_guard<std::mutex> guard(_queues[w].lock);
+        fsAssert(_queues[w].jobs.empty());
+        for (fsu32 i = first; i < last; ++i) {
+            _queues[w].jobs.push_back(i);
+        }
+    }
+    
+    {
+        std::lock_guard<std::mutex> guard(_wakeLock);
+        _generation++;
+    }
+    _wake.notify_all();
+    
+    processJobs(0);
+    
+    std::unique_lock<std::mutex> lock(_wakeLock);
+    _done.wait(lock, [this]{ return _remainingJobs.load() == 0; });
+    _job = nullptr;
+}
+
+void
+mnThreadPool::start(fsu32 workerCount) {
+    if (workerCount == 0) {
+        workerCount = fsMax(std::thread::hardware_concurrency(), 1u);
+    }
+    
+    _workerCount = workerCount;
+    _queues.reset(new WorkQueue[workerCount]);
+    _shutdown = false;
+    
+    for (fsu32 w = 1; w < workerCount; ++w) {
+        _threads.emplace_back(&mnThreadPool::workerLoop, this, w);
+    }
+}
+
+void
+mnThreadPool::stop() {
+    {
+        std::lock_guard<std::mutex> guard(_wakeLock);
+        _shutdown = true;
+    }
+    _wake.notify_all();
+    
+    for (std::thread& thread : _threads) {
+        thread.join();
+    }
+    _threads.clear();
+}
+
+void
+mnThreadPool::workerLoop(fsu32 workerIndex) {
+    fsu64 generation = 0;
+    {
+        std::lock_guard<std::mutex> guard(_wakeLock);
+        generation = _generation;
+    }
+    
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(_wakeLock);
+            _wake.wait(lock, [&]{ return _shutdown || _generation != generation; });
+            if (_shutdown) {
+                return;
+            }
+            generation = _generation;
+        }
+        
+        processJobs(workerIndex);
+    }
+}
+
+void
+mnThreadPool::processJobs(fsu32 workerIndex) {
+    fsu32 jobIndex;
+    while (popJob(workerIndex, jobIndex) || stealJob(workerIndex, jobIndex)) {
+        (*_job)(jobIndex, workerIndex);
+        
+        if (_remainingJobs.fetch_sub(1) == 1) {
+            std::lock_guard<std::mutex> guard(_wakeLock);
+            _done.notify_all();
+        }
+    }
+}
+
+bool
+mnThreadPool::popJob(fsu32 workerIndex, fsu32& jobIndex) {
+    WorkQueue& queue = _queues[workerIndex];
+    std::lock_guard<std::mutex> guard(queue.lock);
+    if (queue.jobs.empty()) {
+        return false;
+    }
+    
+    jobIndex = queue.jobs.front();
+    queue.jobs.pop_front();
+    return true;
+}
+
+bool
+mnThreadPool::stealJob(fsu32 workerIndex, fsu32& jobIndex) {
+    for (fsu32 i = 1; i < _workerCount; ++i) {
+        WorkQueue& victim = _queues[(workerIndex + i) % _workerCount];
+        std::lock_guard<std::mutex> guard(victim.lock);
+        if (!victim.jobs.empty()) {
+            jobIndex = victim.jobs.back();
+            victim.jobs.pop_back();
+            return true;
+        }
+    }
+    
+    return false;
+}
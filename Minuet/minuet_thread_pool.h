@@ -0,0 +1,81 @@
+//
+//  minuet_thread_pool.h
+//  Minuet
+//
+//  Created by Christian Floisand on 2026-10-16.
+//
+
+#pragma once
+#include "minuet_platform.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+#pragma mark - mnTile
+
+/*! @brief A rectangular region of the image, [x0, x1) x [y0, y1). */
+struct mnTile {
+    fsu32 x0, y0;
+    fsu32 x1, y1;
+};
+
+/*! @brief Splits a \c width x \c height image into row-major tiles of at most \c tileSize x \c tileSize pixels. */
+void mn_make_tiles(fsu32 width, fsu32 height, fsu32 tileSize, std::vector<mnTile>& tiles);
+
+
+#pragma mark - mnThreadPool
+
+/*! @brief A fixed set of worker threads that run batches of jobs. Each worker owns a deque of job indices; it consumes its own
+    deque from the front and, once empty, steals from the back of the other workers' deques. */
+struct mnThreadPool {
+    typedef std::function<void(fsu32 jobIndex, fsu32 workerIndex)> JobFunc;
+    
+    /*! @brief Creates a pool with \c workerCount workers, including the calling thread. 0 uses one worker per hardware thread. */
+    explicit mnThreadPool(fsu32 workerCount = 0);
+    ~mnThreadPool();
+    
+    mnThreadPool(const mnThreadPool&) = delete;
+    mnThreadPool& operator=(const mnThreadPool&) = delete;
+    
+    /*! @brief Changes the number of workers. 0 uses one worker per hardware thread. Must not be called during \c run. */
+    void setWorkerCount(fsu32 workerCount);
+    fsu32 getWorkerCount() const { return _workerCount; }
+    
+    /*! @brief Runs \c func for every job index in [0, jobCount) and blocks until all jobs have completed.
+        The calling thread participates as worker 0, so \c workerIndex is always less than \c getWorkerCount(). */
+    void run(fsu32 jobCount, const JobFunc& func);
+
+private:
+    struct WorkQueue {
+        std::mutex lock;
+        std::deque<fsu32> jobs;
+        fsu8 pad_[64]; // Keeps neighbouring queue locks off the same cache line.
+    };
+    
+    void start(fsu32 workerCount);
+    void stop();
+    void workerLoop(fsu32 workerIndex);
+    void processJobs(fsu32 workerIndex);
+    bool popJob(fsu32 workerIndex, fsu32& jobIndex);
+    bool stealJob(fsu32 workerIndex, fsu32& jobIndex);
+
+private:
+    std::vector<std::thread> _threads;
+    std::unique_ptr<WorkQueue[]> _queues;
+    fsu32 _workerCount = 0;
+    
+    const JobFunc * _job = nullptr;
+    std::atomic<fsu32> _remainingJobs;
+    
+    std::mutex _wakeLock;
+    std::condition_variable _wake;
+    std::condition_variable _done;
+    fsu64 _generation = 0;
+    bool _shutdown = false;
+};
@@ -0,0 +1,233 @@
+//
+//  minuet_triangle_soa.cpp
+//  Minuet
+//
+//  Created by Christian Floisand on 2026-10-16.
+//
+
+#include "minuet_triangle_soa.h"
+#include "fs_simd.h"
+
+
+// NOTE(christian): Determinants this close to zero belong to rays that graze the triangle's plane, or to degenerate
+// triangles, including the padding lanes, whose edges are zero.
+static const fsr32 kDeterminantEpsilon = 1e-12f;
+
+
+#pragma mark - mnTriangleSoA
+
+mnTriangleSoA::~mnTriangleSoA() {
+    fs_aligned_free(_memory);
+}
+
+void
+mnTriangleSoA::reset(fsu32 triangleCount) {
+    count = triangleCount;
+    
+    // NOTE(christian): Same padding as mnSphereSoA: one extra SIMD width of lanes that are masked out by index, and can never
+    // produce a hit since their edges are zero.
+    fsu32 paddedCapacity = fs_next_multiple(triangleCount, (fsu32)FS_SIMD_WIDTH) + FS_SIMD_WIDTH;
+    if (paddedCapacity > _capacity || !_memory) {
+        fs_aligned_free(_memory);
+        
+        size_t arraySize = fs_next_multiple((size_t)paddedCapacity * sizeof(fsr32), (size_t)FS_SIMD_ALIGNMENT);
+        _memory = fs_aligned_alloc(arraySize * 10, FS_SIMD_ALIGNMENT);
+        _capacity = paddedCapacity;
+        
+        fsu8 *at = (fsu8 *)_memory;
+        vertexX = (fsr32 *)at; at += arraySize;
+        vertexY = (fsr32 *)at; at += arraySize;
+        vertexZ = (fsr32 *)at; at += arraySize;
+        edge1X = (fsr32 *)at; at += arraySize;
+        edge1Y = (fsr32 *)at; at += arraySize;
+        edge1Z = (fsr32 *)at; at += arraySize;
+        edge2X = (fsr32 *)at; at += arraySize;
+        edge2Y = (fsr32 *)at; at += arraySize;
+        edge2Z = (fsr32 *)at; at += arraySize;
+        objectIndex = (fsi32 *)at;
+    }
+    
+    for (fsu32 i = triangleCount; i < _capacity; ++i) {
+        vertexX[i] = vertexY[i] = vertexZ[i] = 0.f;
+        edge1X[i] = edge1Y[i] = edge1Z[i] = 0.f;
+        edge2X[i] = edge2Y[i] = edge2Z[i] = 0.f;
+        objectIndex[i] = -1;
+    }
+}
+
+void
+mnTriangleSoA::build(const mnMesh& mesh, const std::vector<fsu32>& order, fsu32 first, fsi32 objectBase) {
+    fsAssert(order.size() == mesh.getTriangleCount());
+    fsAssert(first + order.size() <= count);
+    
+    for (fsu32 i = 0; i < (fsu32)order.size(); ++i) {
+        fsu32 triangle = order[i];
+        fsv3f v0 = mesh.getVertex(mesh.indices[triangle * 3 + 0]);
+        fsv3f e1 = mesh.getVertex(mesh.indices[triangle * 3 + 1]) - v0;
+        fsv3f e2 = mesh.getVertex(mesh.indices[triangle * 3 + 2]) - v0;
+        
+        fsu32 lane = first + i;
+        vertexX[lane] = v0.x, vertexY[lane] = v0.y, vertexZ[lane] = v0.z;
+        edge1X[lane] = e1.x, edge1Y[lane] = e1.y, edge1Z[lane] = e1.z;
+        edge2X[lane] = e2.x, edge2Y[lane] = e2.y, edge2Z[lane] = e2.z;
+        objectIndex[lane] = objectBase + (fsi32)triangle;
+    }
+}
+
+
+#pragma mark - Kernel
+
+/*! @brief Möller–Trumbore for one ray against a full SIMD width of triangles starting at lane \c i. Returns the hit distance
+    in each lane, and in \c hit, which lanes hit between 0 and \c tMax. */
+static inline fsWide
+intersectLanes(const mnTriangleSoA& triangles, fsu32 i, fsWide originX, fsWide originY, fsWide originZ, fsWide directionX,
+               fsWide directionY, fsWide directionZ, fsWide tMax, fsWideMask& hit) {
+    fsWide e1X = fs_wide_load(triangles.edge1X + i);
+    fsWide e1Y = fs_wide_load(triangles.edge1Y + i);
+    fsWide e1Z = fs_wide_load(triangles.edge1Z + i);
+    fsWide e2X = fs_wide_load(triangles.edge2X + i);
+    fsWide e2Y = fs_wide_load(triangles.edge2Y + i);
+    fsWide e2Z = fs_wide_load(triangles.edge2Z + i);
+    
+    // p = d x e2, and the determinant is e1 . p.
+    fsWide pX = directionY * e2Z - directionZ * e2Y;
+    fsWide pY = directionZ * e2X - directionX * e2Z;
+    fsWide pZ = directionX * e2Y - directionY * e2X;
+    fsWide determinant = e1X * pX + e1Y * pY + e1Z * pZ;
+    fsWide inverseDeterminant = fs_wide_set1(1.f) / determinant;
+    
+    // Barycentric u from s = o - v0, then v and t from q = s x e1.
+    fsWide sX = originX - fs_wide_load(triangles.vertexX + i);
+    fsWide sY = originY - fs_wide_load(triangles.vertexY + i);
+    fsWide sZ = originZ - fs_wide_load(triangles.vertexZ + i);
+    fsWide u = (sX * pX + sY * pY + sZ * pZ) * inverseDeterminant;
+    fsWide qX = sY * e1Z - sZ * e1Y;
+    fsWide qY = sZ * e1X - sX * e1Z;
+    fsWide qZ = sX * e1Y - sY * e1X;
+    fsWide v = (directionX * qX + directionY * qY + directionZ * qZ) * inverseDeterminant;
+    fsWide t = (e2X * qX + e2Y * qY + e2Z * qZ) * inverseDeterminant;
+    
+    fsWide zero = fs_wide_set1(0.f);
+    fsWide epsilon = fs_wide_set1(kDeterminantEpsilon);
+    hit = ((determinant > epsilon) | (determinant < -epsilon)) & (u >= zero) & (v >= zero) & (fs_wide_set1(1.f) >= u + v) &
+          (t > zero) & (t < tMax);
+    return t;
+}
+
+bool
+mn_intersect_triangles(const mnTriangleSoA& triangles, fsu32 first, fsu32 count, const mnRay& ray, fsr32& hitDistance,
+                       fsu32& lane) {
+    fsWide originX = fs_wide_set1(ray.origin.x);
+    fsWide originY = fs_wide_set1(ray.origin.y);
+    fsWide originZ = fs_wide_set1(ray.origin.z);
+    fsWide directionX = fs_wide_set1(ray.direction.x);
+    fsWide directionY = fs_wide_set1(ray.direction.y);
+    fsWide directionZ = fs_wide_set1(ray.direction.z);
+    fsWideInt end = fs_wide_int_set1((fsi32)(first + count));
+    
+    fsWide closestT = fs_wide_set1(hitDistance);
+    fsWideInt closestLane = fs_wide_int_set1(-1);
+    
+    for (fsu32 i = first; i < first + count; i += FS_SIMD_WIDTH) {
+        fsWideMask hit;
+        fsWide t = intersectLanes(triangles, i, originX, originY, originZ, directionX, directionY, directionZ, closestT, hit);
+        fsWideInt laneIndex = fs_wide_int_ramp((fsi32)i);
+        hit = hit & (laneIndex < end);
+        closestT = fs_wide_select(hit, t, closestT);
+        closestLane = fs_wide_select(hit, laneIndex, closestLane);
+    }
+    
+    fsr32 minT = fs_wide_hmin(closestT);
+    if (minT >= hitDistance) {
+        return false;
+    }
+    
+    fsu32 bits = fs_wide_movemask(closestT == fs_wide_set1(minT));
+    fsi32 lanes[FS_SIMD_WIDTH];
+    fs_wide_int_store(lanes, closestLane);
+    
+    hitDistance = minT;
+    lane = (fsu32)lanes[fs_ffs(bits) - 1];
+    return true;
+}
+
+bool
+mn_occluded_triangles(const mnTriangleSoA& triangles, fsu32 first, fsu32 count, const mnRay& ray, fsr32 maxDistance) {
+    fsWide originX = fs_wide_set1(ray.origin.x);
+    fsWide originY = fs_wide_set1(ray.origin.y);
+    fsWide originZ = fs_wide_set1(ray.origin.z);
+    fsWide directionX = fs_wide_set1(ray.direction.x);
+    fsWide directionY = fs_wide_set1(ray.direction.y);
+    fsWide directionZ = fs_wide_set1(ray.direction.z);
+    fsWide tMax = fs_wide_set1(maxDistance);
+    fsWideInt end = fs_wide_int_set1((fsi32)(first + count));
+    
+    for (fsu32 i = first; i < first + count; i += FS_SIMD_WIDTH) {
+        fsWideMask hit;
+        intersectLanes(triangles, i, originX, originY, originZ, directionX, directionY, directionZ, tMax, hit);
+        if (fs_wide_movemask(hit & (fs_wide_int_ramp((fsi32)i) < end)) != 0) {
+            return true;
+        }
+    }
+    
+    return false;
+}
+
+fsu32
+mn_intersect_triangles_packet(const mnTriangleSoA& triangles, fsu32 first, fsu32 count, mnRayPacket& packet) {
+    fsr32 maxDistance = packet.getMaxHitDistance();
+    fsWide zero = fs_wide_set1(0.f);
+    fsWide one = fs_wide_set1(1.f);
+    fsWide epsilon = fs_wide_set1(kDeterminantEpsilon);
+    fsu32 testedCount = 0;
+    
+    for (fsu32 triangle = first; triangle < first + count; ++triangle) {
+        fsv3f v0 = {triangles.vertexX[triangle], triangles.vertexY[triangle], triangles.vertexZ[triangle]};
+        fsv3f e1 = {triangles.edge1X[triangle], triangles.edge1Y[triangle], triangles.edge1Z[triangle]};
+        fsv3f e2 = {triangles.edge2X[triangle], triangles.edge2Y[triangle], triangles.edge2Z[triangle]};
+        fsv3f v1 = v0 + e1;
+        fsv3f v2 = v0 + e2;
+        fsv3f boundsMin = {fsMin(v0.x, fsMin(v1.x, v2.x)), fsMin(v0.y, fsMin(v1.y, v2.y)), fsMin(v0.z, fsMin(v1.z, v2.z))};
+        fsv3f boundsMax = {fsMax(v0.x, fsMax(v1.x, v2.x)), fsMax(v0.y, fsMax(v1.y, v2.y)), fsMax(v0.z, fsMax(v1.z, v2.z))};
+        if (mn_intersect_aabb_packet(packet, boundsMin, boundsMax, maxDistance) == FLT_MAX) {
+            continue;
+        }
+        testedCount++;
+        
+        fsWide vertexX = fs_wide_set1(v0.x), vertexY = fs_wide_set1(v0.y), vertexZ = fs_wide_set1(v0.z);
+        fsWide e1X = fs_wide_set1(e1.x), e1Y = fs_wide_set1(e1.y), e1Z = fs_wide_set1(e1.z);
+        fsWide e2X = fs_wide_set1(e2.x), e2Y = fs_wide_set1(e2.y), e2Z = fs_wide_set1(e2.z);
+        fsWideInt object = fs_wide_int_set1(triangles.objectIndex[triangle]);
+        
+        // Same Möller–Trumbore as mn_intersect_triangles, with the ray and triangle roles swapped across lanes.
+        for (fsu32 i = 0; i < packet.paddedCount; i += FS_SIMD_WIDTH) {
+            fsWide directionX = fs_wide_load(packet.directionX + i);
+            fsWide directionY = fs_wide_load(packet.directionY + i);
+            fsWide directionZ = fs_wide_load(packet.directionZ + i);
+            
+            fsWide pX = directionY * e2Z - directionZ * e2Y;
+            fsWide pY = directionZ * e2X - directionX * e2Z;
+            fsWide pZ = directionX * e2Y - directionY * e2X;
+            fsWide determinant = e1X * pX + e1Y * pY + e1Z * pZ;
+            fsWide inverseDeterminant = one / determinant;
+            
+            fsWide sX = fs_wide_load(packet.originX + i) - vertexX;
+            fsWide sY = fs_wide_load(packet.originY + i) - vertexY;
+            fsWide sZ = fs_wide_load(packet.originZ + i) - vertexZ;
+            fsWide u = (sX * pX + sY * pY + sZ * pZ) * inverseDeterminant;
+            fsWide qX = sY * e1Z - sZ * e1Y;
+            fsWide qY = sZ * e1X - sX * e1Z;
+            fsWide qZ = sX * e1Y - sY * e1X;
+            fsWide v = (directionX * qX + directionY * qY + directionZ * qZ) * inverseDeterminant;
+            fsWide t = (e2X * qX + e2Y * qY + e2Z * qZ) * inverseDeterminant;
+            
+            fsWide closestT = fs_wide_load(packet.hitDistance + i);
+            fsWideMask hit = ((determinant > epsilon) | (determinant < -epsilon)) & (u >= zero) & (v >= zero) &
+                             (one >= u + v) & (t > zero) & (t < closestT);
+            fs_wide_store(packet.hitDistance + i, fs_wide_select(hit, t, closestT));
+            fs_wide_int_store(packet.hitObject + i, fs_wide_select(hit, object, fs_wide_int_load(packet.hitObject + i)));
+        }
+    }
+    
+    return testedCount;
+}
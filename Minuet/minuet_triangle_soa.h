@@ -0,0 +1,64 @@
+//
+//  minuet_triangle_soa.h
+//  Minuet
+//
+//  Created by Christian Floisand on 2026-10-16.
+//
+
+#pragma once
+#include "minuet_platform.h"
+#include "minuet_ray.h"
+#include "minuet_ray_packet.h"
+#include "minuet_scene.h"
+#include <vector>
+
+
+#pragma mark - mnTriangleSoA
+
+/*! @brief The triangles of every mesh in a scene, packed as a structure of arrays for the wide intersection kernel. Each
+    triangle is stored as one vertex and the two edges leaving it, which is what Möller–Trumbore works from. Like
+    \c mnSphereSoA, the arrays are aligned and padded by one SIMD width, and each mesh's triangles are stored in the order of
+    its BVH's primitives, so every leaf maps to a contiguous run of lanes. */
+struct mnTriangleSoA {
+    mnTriangleSoA() = default;
+    ~mnTriangleSoA();
+    
+    mnTriangleSoA(const mnTriangleSoA&) = delete;
+    mnTriangleSoA& operator=(const mnTriangleSoA&) = delete;
+    
+    /*! @brief Makes room for \c count triangles, dropping whatever was stored. */
+    void reset(fsu32 count);
+    /*! @brief Fills lanes [first, first + order.size()) from \c mesh, where lane \c first + i holds triangle \c order[i] and
+        reports it as \c objectBase + order[i]. */
+    void build(const mnMesh& mesh, const std::vector<fsu32>& order, fsu32 first, fsi32 objectBase);
+
+public:
+    fsr32 *vertexX = nullptr;
+    fsr32 *vertexY = nullptr;
+    fsr32 *vertexZ = nullptr;
+    fsr32 *edge1X = nullptr;
+    fsr32 *edge1Y = nullptr;
+    fsr32 *edge1Z = nullptr;
+    fsr32 *edge2X = nullptr;
+    fsr32 *edge2Y = nullptr;
+    fsr32 *edge2Z = nullptr;
+    fsi32 *objectIndex = nullptr;   // The renderer's object index of the triangle.
+    fsu32 count = 0;
+
+private:
+    void *_memory = nullptr;
+    fsu32 _capacity = 0;
+};
+
+/*! @brief Intersects \c ray with lanes [first, first + count) several triangles at a time. If a hit closer than \c hitDistance
+    is found, \c hitDistance and \c lane are updated and true is returned. Triangles are two-sided. */
+bool mn_intersect_triangles(const mnTriangleSoA& triangles, fsu32 first, fsu32 count, const mnRay& ray, fsr32& hitDistance,
+                            fsu32& lane);
+
+/*! @brief Returns true as soon as any of lanes [first, first + count) is hit by \c ray closer than \c maxDistance. */
+bool mn_occluded_triangles(const mnTriangleSoA& triangles, fsu32 first, fsu32 count, const mnRay& ray, fsr32 maxDistance);
+
+/*! @brief Intersects every ray in \c packet with lanes [first, first + count), several rays at a time. Triangles whose bounds
+    the packet can't reach are skipped. Updates each ray's \c hitDistance and \c hitObject, and returns the number of triangles
+    tested. */
+fsu32 mn_intersect_triangles_packet(const mnTriangleSoA& triangles, fsu32 first, fsu32 count, mnRayPacket& packet);
@@ -0,0 +1,64 @@
+//
+//  minuet_wavefront.cpp
+//  Minuet
+//
+//  Created by Christian Floisand on 2026-10-16.
+//
+
+#include "minuet_wavefront.h"
+#include "fs_simd.h"
+
+
+#pragma mark - mnPathQueue
+
+static const fsu32 kPathQueueArrayCount = 24;
+
+mnPathQueue::~mnPathQueue() {
+    fs_aligned_free(_memory);
+}
+
+void
+mnPathQueue::reserve(fsu32 capacity) {
+    count = 0;
+    if (capacity <= _capacity && _memory) {
+        return;
+    }
+    
+    fs_aligned_free(_memory);
+    
+    size_t arraySize = fs_next_multiple((size_t)capacity * sizeof(fsr32), (size_t)FS_SIMD_ALIGNMENT);
+    _memory = fs_aligned_alloc(arraySize * kPathQueueArrayCount, FS_SIMD_ALIGNMENT);
+    _capacity = capacity;
+    
+    fsu8 *at = (fsu8 *)_memory;
+    fsr32 **arrays[] = {
+        &originX, &originY, &originZ, &directionX, &directionY, &directionZ, &throughputR, &throughputG, &throughputB,
+        &bsdfPdf, &hitDistance, &shadowOriginX, &shadowOriginY, &shadowOriginZ, &shadowDirectionX, &shadowDirectionY,
+        &shadowDirectionZ, &shadowDistance, &shadowR, &shadowG, &shadowB
+    };
+    for (fsr32 **array : arrays) {
+        *array = (fsr32 *)at;
+        at += arraySize;
+    }
+    pixelIndex = (fsu32 *)at; at += arraySize;
+    sampleIndex = (fsu32 *)at; at += arraySize;
+    objectIndex = (fsi32 *)at; at += arraySize;
+    
+    static_assert(fsArrayCount(arrays) + 3 == kPathQueueArrayCount, "Every path queue array needs a slice of the allocation.");
+}
+
+void
+mnPathQueue::copyPath(fsu32 dstIndex, const mnPathQueue& src, fsu32 srcIndex) {
+    pixelIndex[dstIndex] = src.pixelIndex[srcIndex];
+    sampleIndex[dstIndex] = src.sampleIndex[srcIndex];
+    originX[dstIndex] = src.originX[srcIndex];
+    originY[dstIndex] = src.originY[srcIndex];
+    originZ[dstIndex] = src.originZ[srcIndex];
+    directionX[dstIndex] = src.directionX[srcIndex];
+    directionY[dstIndex] = src.directionY[srcIndex];
+    directionZ[dstIndex] = src.directionZ[srcIndex];
+    throughputR[dstIndex] = src.throughputR[srcIndex];
+    throughputG[dstIndex] = src.throughputG[srcIndex];
+    throughputB[dstIndex] = src.throughputB[srcIndex];
+    bsdfPdf[dstIndex] = src.bsdfPdf[srcIndex];
+}
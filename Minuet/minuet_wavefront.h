@@ -0,0 +1,75 @@
+//
+//  minuet_wavefront.h
+//  Minuet
+//
+//  Created by Christian Floisand on 2026-10-16.
+//
+
+#pragma once
+#include "minuet_platform.h"
+#include "minuet_ray.h"
+#include <atomic>
+
+
+#pragma mark - mnPathQueue
+
+/*! @brief Structure-of-arrays state for a batch of in-flight paths, one entry per path, used by the wavefront renderer. Each
+    bounce reads one queue and compacts the surviving paths into another. Alongside each path is the shadow ray its shading
+    stage may have produced; a non-positive \c shadowDistance means there is none. */
+struct mnPathQueue {
+    mnPathQueue() = default;
+    ~mnPathQueue();
+    
+    mnPathQueue(const mnPathQueue&) = delete;
+    mnPathQueue& operator=(const mnPathQueue&) = delete;
+    
+    /*! @brief Makes room for \c capacity paths. Existing contents are discarded if the queue has to grow. */
+    void reserve(fsu32 capacity);
+    fsu32 getCapacity() const { return _capacity; }
+    
+    mnRay getRay(fsu32 index) const {
+        mnRay ray;
+        ray.origin = {originX[index], originY[index], originZ[index]};
+        ray.direction = {directionX[index], directionY[index], directionZ[index]};
+        return ray;
+    }
+    
+    void setRay(fsu32 index, const mnRay& ray) {
+        originX[index] = ray.origin.x, originY[index] = ray.origin.y, originZ[index] = ray.origin.z;
+        directionX[index] = ray.direction.x, directionY[index] = ray.direction.y, directionZ[index] = ray.direction.z;
+    }
+    
+    fsv3f getThroughput(fsu32 index) const { return {throughputR[index], throughputG[index], throughputB[index]}; }
+    
+    void setThroughput(fsu32 index, const fsv3f& throughput) {
+        throughputR[index] = throughput.r, throughputG[index] = throughput.g, throughputB[index] = throughput.b;
+    }
+    
+    /*! @brief Copies every per-path field (not the shadow ray) of entry \c srcIndex in \c src to entry \c dstIndex. */
+    void copyPath(fsu32 dstIndex, const mnPathQueue& src, fsu32 srcIndex);
+
+public:
+    // Path state.
+    fsu32 *pixelIndex = nullptr;
+    fsu32 *sampleIndex = nullptr;   // With pixelIndex and the bounce depth, where the path is in the sampler's sequence
+    fsr32 *originX = nullptr, *originY = nullptr, *originZ = nullptr;
+    fsr32 *directionX = nullptr, *directionY = nullptr, *directionZ = nullptr;
+    fsr32 *throughputR = nullptr, *throughputG = nullptr, *throughputB = nullptr;
+    fsr32 *bsdfPdf = nullptr;       // Pdf of the bounce that produced the current ray, for MIS against light sampling
+    
+    // Closest hit of the current ray, written by the intersection stage. objectIndex is -1 on a miss.
+    fsr32 *hitDistance = nullptr;
+    fsi32 *objectIndex = nullptr;
+    
+    // Shadow ray produced by the shading stage.
+    fsr32 *shadowOriginX = nullptr, *shadowOriginY = nullptr, *shadowOriginZ = nullptr;
+    fsr32 *shadowDirectionX = nullptr, *shadowDirectionY = nullptr, *shadowDirectionZ = nullptr;
+    fsr32 *shadowDistance = nullptr;
+    fsr32 *shadowR = nullptr, *shadowG = nullptr, *shadowB = nullptr;
+    
+    std::atomic<fsu32> count;
+
+private:
+    void *_memory = nullptr;
+    fsu32 _capacity = 0;
+};